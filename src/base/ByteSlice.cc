@@ -0,0 +1,117 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <string.h>
+
+#include "ByteSlice.h"
+
+
+ByteSlice::ByteSlice(const ByteSlice& other) : pieces(other.pieces), length(other.length)
+{
+    for (Pieces::iterator it = pieces.begin(); it != pieces.end(); ++it)
+        it->chunk->addRef();
+}
+
+ByteSlice& ByteSlice::operator=(const ByteSlice& other)
+{
+    if (this == &other)
+        return *this;
+    for (Pieces::const_iterator it = other.pieces.begin(); it != other.pieces.end(); ++it)
+        it->chunk->addRef();
+    clear();
+    pieces = other.pieces;
+    length = other.length;
+    return *this;
+}
+
+void ByteSlice::append(ByteChunk *chunk, unsigned int offset, unsigned int len)
+{
+    ASSERT(offset + len <= chunk->getLength());
+    if (len == 0)
+        return;
+
+    // extend the last piece if the new range continues it
+    if (!pieces.empty())
+    {
+        Piece& last = pieces.back();
+        if (last.chunk == chunk && last.offset + last.length == offset)
+        {
+            last.length += len;
+            length += len;
+            return;
+        }
+    }
+    chunk->addRef();
+    pieces.push_back(Piece(chunk, offset, len));
+    length += len;
+}
+
+void ByteSlice::clear()
+{
+    for (Pieces::iterator it = pieces.begin(); it != pieces.end(); ++it)
+        it->chunk->release();
+    pieces.clear();
+    length = 0;
+}
+
+unsigned int ByteSlice::copyDataToBuffer(void *ptr, unsigned int len, unsigned int srcOffs) const
+{
+    unsigned int copiedBytes = 0;
+    for (Pieces::const_iterator it = pieces.begin(); copiedBytes < len && it != pieces.end(); ++it)
+    {
+        if (srcOffs >= it->length)
+        {
+            srcOffs -= it->length;
+            continue;
+        }
+        unsigned int cbytes = std::min(it->length - srcOffs, len - copiedBytes);
+        memcpy((char *)ptr + copiedBytes, it->chunk->getData() + it->offset + srcOffs, cbytes);
+        copiedBytes += cbytes;
+        srcOffs = 0;
+    }
+    return copiedBytes;
+}
+
+void ByteSlice::truncate(unsigned int truncleft, unsigned int truncright)
+{
+    ASSERT(truncleft + truncright <= length);
+    length -= truncleft + truncright;
+
+    Pieces::iterator first = pieces.begin();
+    while (truncleft > 0 && truncleft >= first->length)
+    {
+        truncleft -= first->length;
+        first->chunk->release();
+        ++first;
+    }
+    pieces.erase(pieces.begin(), first);
+    if (truncleft > 0)
+    {
+        pieces.front().offset += truncleft;
+        pieces.front().length -= truncleft;
+    }
+
+    while (truncright > 0 && truncright >= pieces.back().length)
+    {
+        truncright -= pieces.back().length;
+        pieces.back().chunk->release();
+        pieces.pop_back();
+    }
+    if (truncright > 0)
+        pieces.back().length -= truncright;
+}
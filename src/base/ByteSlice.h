@@ -0,0 +1,118 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_BYTESLICE_H
+#define __INET_BYTESLICE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+
+/**
+ * Reference counted, fixed-size block of raw bytes. Bytes that were already
+ * written into a chunk are never modified, so several ByteSlice objects may
+ * refer to the same chunk while its owner keeps appending to the unused tail.
+ */
+class INET_API ByteChunk
+{
+  protected:
+    char *data;
+    unsigned int capacity;
+    unsigned int length;    // number of bytes written so far
+    int refCount;
+
+  private:
+    // not copyable
+    ByteChunk(const ByteChunk&);
+    ByteChunk& operator=(const ByteChunk&);
+    ~ByteChunk() { delete [] data; }
+
+  public:
+    /** Creates a chunk with reference count 1. */
+    ByteChunk(unsigned int capacity) : data(new char[capacity]), capacity(capacity), length(0), refCount(1) {}
+
+    void addRef() { refCount++; }
+    void release() { if (--refCount == 0) delete this; }
+    int getRefCount() const { return refCount; }
+
+    const char *getData() const { return data; }
+    unsigned int getCapacity() const { return capacity; }
+    unsigned int getLength() const { return length; }
+    unsigned int getFreeSpace() const { return capacity - length; }
+
+    /**
+     * Returns a pointer to the unused tail of the chunk. After writing at most
+     * getFreeSpace() bytes there, call extend() with the number of bytes written.
+     */
+    char *getFreeSpacePtr() { return data + length; }
+    void extend(unsigned int len) { ASSERT(len <= capacity - length); length += len; }
+};
+
+/**
+ * A read-only view of a byte sequence that is stored in one or more
+ * ByteChunk objects. Copying, truncating and destroying a slice only adjusts
+ * reference counts; the payload bytes themselves are never copied.
+ */
+class INET_API ByteSlice
+{
+  protected:
+    struct Piece
+    {
+        ByteChunk *chunk;
+        unsigned int offset;
+        unsigned int length;
+        Piece(ByteChunk *chunk, unsigned int offset, unsigned int length) : chunk(chunk), offset(offset), length(length) {}
+    };
+    typedef std::vector<Piece> Pieces;
+
+    Pieces pieces;
+    unsigned int length;
+
+  public:
+    ByteSlice() : length(0) {}
+    ByteSlice(const ByteSlice& other);
+    ~ByteSlice() { clear(); }
+    ByteSlice& operator=(const ByteSlice& other);
+
+    /** Appends the given byte range of the chunk to the end of the slice. */
+    void append(ByteChunk *chunk, unsigned int offset, unsigned int length);
+
+    /** Releases all chunks. */
+    void clear();
+
+    bool isEmpty() const { return length == 0; }
+    unsigned int getLength() const { return length; }
+
+    /**
+     * Copy data content to buffer
+     * @param ptr: pointer to output buffer
+     * @param length: length of buffer, maximum of copied bytes
+     * @param srcOffs: number of skipped bytes from source
+     * @return: length of copied data
+     */
+    unsigned int copyDataToBuffer(void *ptr, unsigned int length, unsigned int srcOffs = 0) const;
+
+    /**
+     * Truncate the slice
+     * @param truncleft: The number of bytes from the beginning of the content be remove
+     * @param truncright: The number of bytes from the end of the content be remove
+     */
+    void truncate(unsigned int truncleft, unsigned int truncright = 0);
+};
+
+#endif
@@ -0,0 +1,160 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_OPENADDRESSINGTABLE_H
+#define __INET_OPENADDRESSINGTABLE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+
+/**
+ * Hash table with open addressing (linear probing), for the lookups on the
+ * per-packet path: TCP demultiplexing, the MAC address table of switches,
+ * interface addresses and the filters of MultiFieldClassifier.
+ *
+ * Key must have operator==; HashFunction is a functor returning the uint32
+ * hash of a key. The low bits of the hash select the home slot, so they must
+ * be well mixed (multiplicative hashing is used by all users of the table).
+ *
+ * The table doubles its size to keep the load factor at most 1/2, so that
+ * probe sequences stay short. remove() uses backward shift deletion: later
+ * entries of the probe sequence are moved into the hole, so that lookups
+ * never need tombstones and stop at the first empty slot.
+ *
+ * Pointers returned by find() are invalidated by insert() and remove().
+ */
+template <typename Key, typename Value, typename HashFunction>
+class OpenAddressingTable
+{
+  protected:
+    struct Slot
+    {
+        Key key;
+        Value value;
+        uint32 hash;
+        bool used;
+        Slot() : key(), value(), hash(0), used(false) {}
+    };
+
+    std::vector<Slot> slots;    // size is 0 or a power of 2
+    int numEntries;
+    int initialSize;
+    HashFunction hashFunction;
+
+  protected:
+    /** Returns the slot holding the key, or the empty slot where it belongs. There must be at least one slot. */
+    int findSlot(const Key& key, uint32 h) const {
+        unsigned int mask = slots.size() - 1;
+        for (unsigned int i = h & mask; ; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (!slot.used || (slot.hash == h && slot.key == key))
+                return i;
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> oldSlots;
+        oldSlots.swap(slots);
+        slots.resize(oldSlots.empty() ? initialSize : 2 * oldSlots.size());
+        for (typename std::vector<Slot>::iterator it = oldSlots.begin(); it != oldSlots.end(); ++it)
+            if (it->used)
+                slots[findSlot(it->key, it->hash)] = *it;
+    }
+
+  public:
+    /** The slots are allocated on the first insertion; initialSize must be a power of 2. */
+    OpenAddressingTable(int initialSize = 16) : numEntries(0), initialSize(initialSize) {}
+
+    int size() const { return numEntries; }
+
+    bool empty() const { return numEntries == 0; }
+
+    /** Removes all entries, but keeps the allocated slots. */
+    void clear() {
+        for (typename std::vector<Slot>::iterator it = slots.begin(); it != slots.end(); ++it)
+            it->used = false;
+        numEntries = 0;
+    }
+
+    /** Returns the value stored for the key, or NULL. */
+    Value *find(const Key& key) {
+        if (numEntries == 0)
+            return NULL;
+        Slot& slot = slots[findSlot(key, hashFunction(key))];
+        return slot.used ? &slot.value : NULL;
+    }
+
+    const Value *find(const Key& key) const {
+        if (numEntries == 0)
+            return NULL;
+        const Slot& slot = slots[findSlot(key, hashFunction(key))];
+        return slot.used ? &slot.value : NULL;
+    }
+
+    /** Adds the entry and returns true, unless the key is already in the table (its value is kept then). */
+    bool insert(const Key& key, const Value& value) {
+        if (2 * (numEntries + 1) > (int)slots.size())
+            grow();
+        uint32 h = hashFunction(key);
+        Slot& slot = slots[findSlot(key, h)];
+        if (slot.used)
+            return false;
+        slot.key = key;
+        slot.value = value;
+        slot.hash = h;
+        slot.used = true;
+        numEntries++;
+        return true;
+    }
+
+    /** Removes the entry with the given key; returns false if there was none. */
+    bool remove(const Key& key) {
+        if (numEntries == 0)
+            return false;
+        unsigned int hole = findSlot(key, hashFunction(key));
+        if (!slots[hole].used)
+            return false;
+        unsigned int mask = slots.size() - 1;
+        for (unsigned int j = (hole + 1) & mask; slots[j].used; j = (j + 1) & mask) {
+            unsigned int home = slots[j].hash & mask;
+            // move slot j unless its home lies cyclically in (hole, j]
+            bool inRange = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!inRange) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].used = false;
+        numEntries--;
+        return true;
+    }
+
+    /** The number of allocated slots; for tests. */
+    int getNumSlots() const { return slots.size(); }
+
+    /** The index of the slot holding the key, or -1; for tests. */
+    int getSlotIndex(const Key& key) const {
+        if (numEntries == 0)
+            return -1;
+        int i = findSlot(key, hashFunction(key));
+        return slots[i].used ? i : -1;
+    }
+};
+
+#endif
@@ -0,0 +1,142 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <string>
+#include <vector>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "ParallelLoop.h"
+
+
+namespace {
+
+struct LoopState
+{
+    ParallelLoop::Body *body;
+    int numIterations;
+    int nextIteration;
+    int failedIteration;    // lowest failed iteration index, or -1
+    std::string errorMessage;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t mutex;
+#endif
+};
+
+void runIteration(LoopState *state, int i)
+{
+    std::string errorMessage;
+    try
+    {
+        state->body->run(i);
+        return;
+    }
+    catch (std::exception& e)
+    {
+        errorMessage = e.what();
+    }
+    catch (...)
+    {
+        errorMessage = "unknown exception";
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&state->mutex);
+#endif
+    if (state->failedIteration == -1 || i < state->failedIteration)
+    {
+        state->failedIteration = i;
+        state->errorMessage = errorMessage;
+    }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&state->mutex);
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+void *runWorker(void *arg)
+{
+    LoopState *state = (LoopState *)arg;
+    while (true)
+    {
+        pthread_mutex_lock(&state->mutex);
+        int i = state->nextIteration++;
+        pthread_mutex_unlock(&state->mutex);
+        if (i >= state->numIterations)
+            return NULL;
+        runIteration(state, i);
+    }
+}
+#endif
+
+}  // namespace
+
+int ParallelLoop::getNumProcessors()
+{
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+void ParallelLoop::run(int numThreads, int numIterations, Body *body)
+{
+    if (numThreads <= 0)
+        numThreads = getNumProcessors();
+    if (numThreads > numIterations)
+        numThreads = numIterations;
+
+    LoopState state;
+    state.body = body;
+    state.numIterations = numIterations;
+    state.nextIteration = 0;
+    state.failedIteration = -1;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&state.mutex, NULL);
+    if (numThreads > 1)
+    {
+        // the calling thread is one of the workers
+        std::vector<pthread_t> threads;
+        for (int i = 1; i < numThreads; i++)
+        {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, runWorker, &state) == 0)
+                threads.push_back(thread);
+        }
+        runWorker(&state);
+        for (int i = 0; i < (int)threads.size(); i++)
+            pthread_join(threads[i], NULL);
+    }
+    else
+#endif
+    {
+        for (int i = 0; i < numIterations && state.failedIteration == -1; i++)
+            runIteration(&state, i);
+    }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&state.mutex);
+#endif
+
+    if (state.failedIteration != -1)
+        throw cRuntimeError("%s", state.errorMessage.c_str());
+}
@@ -0,0 +1,62 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PARALLELLOOP_H
+#define __INET_PARALLELLOOP_H
+
+#include "INETDefs.h"
+
+
+/**
+ * Runs the iterations of a loop on several threads. Only meant for
+ * self-contained computations (e.g. in initialize()) that do not touch
+ * the simulation kernel: iterations must not log, create owned objects,
+ * or modify shared state without their own synchronization.
+ *
+ * Threads are only used if INET was compiled with HAVE_PTHREAD; otherwise
+ * the iterations are executed sequentially in the calling thread.
+ */
+class INET_API ParallelLoop
+{
+  public:
+    /** The loop body; run() is called exactly once for every iteration index. */
+    class INET_API Body
+    {
+      public:
+        virtual ~Body() {}
+        virtual void run(int i) = 0;
+    };
+
+  public:
+    /**
+     * Returns the number of available processors, or 1 if this cannot be
+     * determined or threads are not supported.
+     */
+    static int getNumProcessors();
+
+    /**
+     * Runs body->run(i) for every i in [0, numIterations) using at most numThreads
+     * threads (numThreads <= 0 means getNumProcessors()), and returns when all
+     * iterations have finished. The order in which iterations are executed is
+     * unspecified. If iterations throw, the error of the first failed iteration
+     * (lowest index) is rethrown as cRuntimeError in the calling thread.
+     */
+    static void run(int numThreads, int numIterations, Body *body);
+};
+
+#endif
+
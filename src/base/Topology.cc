@@ -18,8 +18,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
-#include <deque>
-#include <list>
 #include <algorithm>
 #include <sstream>
 #include "Topology.h"
@@ -377,14 +375,13 @@ void Topology::calculateUnweightedSingleShortestPathsTo(Node *_target)
     }
     target->dist = 0;
 
-    std::deque<Node*> q;
+    // FIFO queue: nodes are appended to 'queue', and never removed until the end
+    queue.clear();
+    queue.push_back(target);
 
-    q.push_back(target);
-
-    while (!q.empty())
+    for (int k=0; k<(int)queue.size(); k++)
     {
-       Node *v = q.front();
-       q.pop_front();
+       Node *v = queue[k];
 
        // for each w adjacent to v...
        for (int i=0; i<(int)v->inLinks.size(); i++)
@@ -400,10 +397,62 @@ void Topology::calculateUnweightedSingleShortestPathsTo(Node *_target)
            {
                w->dist = v->dist + 1;
                w->outPath = v->inLinks[i];
-               q.push_back(w);
+               queue.push_back(w);
            }
        }
     }
+    queue.clear();
+}
+
+void Topology::moveUpInQueue(Node *node)
+{
+    int i = node->queueIndex;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!isQueuedBefore(node, queue[parent]))
+            break;
+        queue[i] = queue[parent];
+        queue[i]->queueIndex = i;
+        i = parent;
+    }
+    queue[i] = node;
+    node->queueIndex = i;
+}
+
+void Topology::moveDownInQueue(Node *node)
+{
+    int n = queue.size();
+    int i = node->queueIndex;
+    while (true)
+    {
+        int child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && isQueuedBefore(queue[child + 1], queue[child]))
+            child++;
+        if (!isQueuedBefore(queue[child], node))
+            break;
+        queue[i] = queue[child];
+        queue[i]->queueIndex = i;
+        i = child;
+    }
+    queue[i] = node;
+    node->queueIndex = i;
+}
+
+Topology::Node *Topology::removeFirstFromQueue()
+{
+    Node *first = queue[0];
+    first->queueIndex = -1;
+    Node *last = queue.back();
+    queue.pop_back();
+    if (last != first)
+    {
+        last->queueIndex = 0;
+        moveDownInQueue(last);
+    }
+    return first;
 }
 
 void Topology::calculateWeightedSingleShortestPathsTo(Node *_target)
@@ -417,52 +466,56 @@ void Topology::calculateWeightedSingleShortestPathsTo(Node *_target)
     {
        nodes[i]->dist = INFINITY;
        nodes[i]->outPath = NULL;
+       nodes[i]->queueIndex = -1;
     }
 
     target->dist = 0;
 
-    std::list<Node*> q;
+    // nodes with equal distance are processed in insertion order (a node
+    // whose distance decreases counts as inserted again)
+    unsigned int queueOrder = 0;
+    queue.clear();
+    target->queueOrder = queueOrder++;
+    target->queueIndex = 0;
+    queue.push_back(target);
 
-    q.push_back(target);
-
-    while (!q.empty())
+    while (!queue.empty())
     {
-        Node *dest = q.front();
-        q.pop_front();
+        Node *dest = removeFirstFromQueue();
 
         ASSERT(dest->getWeight() >= 0.0);
 
         // for each w adjacent to v...
-        for (int i=0; i < dest->getNumInLinks(); i++)
+        for (int i=0; i < (int)dest->inLinks.size(); i++)
         {
-            if (!(dest->getLinkIn(i)->isEnabled()))
+            Link *link = dest->inLinks[i];
+            if (!link->enabled)
                 continue;
 
-            Node *src = dest->getLinkIn(i)->getRemoteNode();
-            if (!src->isEnabled())
+            Node *src = link->srcNode;
+            if (!src->enabled)
                 continue;
 
-            double linkWeight = dest->getLinkIn(i)->getWeight();
+            double linkWeight = link->weight;
             ASSERT(linkWeight > 0.0);
 
             double newdist = dest->dist + linkWeight;
             if (dest != target)
-                newdist += dest->getWeight();  // dest is not the target, uses weight of dest node as price of routing (infinity means dest node doesn't route between interfaces)
+                newdist += dest->weight;  // dest is not the target, uses weight of dest node as price of routing (infinity means dest node doesn't route between interfaces)
             if (newdist != INFINITY && src->dist > newdist)  // it's a valid shorter path from src to target node
             {
-                if (src->dist != INFINITY)
-                    q.remove(src);   // src is in the queue
                 src->dist = newdist;
-                src->outPath = dest->inLinks[i];
-
-                // insert src node to ordered list
-                std::list<Node*>::iterator it;
-                for (it = q.begin(); it != q.end(); ++it)
-                    if ((*it)->dist > newdist)
-                        break;
-                q.insert(it, src);
+                src->outPath = link;
+                src->queueOrder = queueOrder++;
+                if (src->queueIndex == -1)
+                {
+                    src->queueIndex = queue.size();
+                    queue.push_back(src);
+                }
+                // decrease-key; a newer queueOrder may only delay src among equal distances,
+                // but its distance decreased strictly, so moving up is sufficient
+                moveUpInQueue(src);
             }
         }
     }
 }
-
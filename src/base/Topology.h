@@ -79,12 +79,14 @@ class INET_API Topology : public cOwnedObject
         // variables used by the shortest-path algorithms
         double dist;
         Link *outPath;
+        int queueIndex;           // position in Topology's priority queue, -1 if not in the queue
+        unsigned int queueOrder;  // insertion order into the priority queue, breaks ties between equal distances
 
       public:
         /**
          * Constructor
          */
-        Node(int moduleId=-1) {this->moduleId=moduleId; weight=0; enabled=true; dist=INFINITY; outPath=NULL;}
+        Node(int moduleId=-1) {this->moduleId=moduleId; weight=0; enabled=true; dist=INFINITY; outPath=NULL; queueIndex=-1; queueOrder=0;}
         virtual ~Node() {}
 
         /** @name Node attributes: weight, enabled state, correspondence to modules. */
@@ -334,6 +336,10 @@ class INET_API Topology : public cOwnedObject
     std::vector<Node*> nodes;
     Node *target;
 
+    // workspace of the shortest path algorithms, kept between calls to avoid reallocation:
+    // a FIFO queue for the unweighted, and a binary heap ordered by (dist, queueOrder) for the weighted one
+    std::vector<Node*> queue;
+
     // note: the purpose of the (unsigned int) cast is that nodes with moduleId==-1 are inserted at the end of the vector
     static bool lessByModuleId(Node *a, Node *b) { return (unsigned int)a->moduleId < (unsigned int)b->moduleId; }
     static bool isModuleIdLess(Node *a, int moduleId) { return (unsigned int)a->moduleId < (unsigned int)moduleId; }
@@ -341,6 +347,12 @@ class INET_API Topology : public cOwnedObject
     void unlinkFromSourceNode(Link *link);
     void unlinkFromDestNode(Link *link);
 
+    // binary heap operations on 'queue'
+    static bool isQueuedBefore(Node *a, Node *b) { return a->dist < b->dist || (a->dist == b->dist && a->queueOrder < b->queueOrder); }
+    void moveUpInQueue(Node *node);
+    void moveDownInQueue(Node *node);
+    Node *removeFirstFromQueue();
+
   public:
     /** @name Constructors, destructor, assignment */
     //@{
@@ -556,7 +568,8 @@ class INET_API Topology : public cOwnedObject
     /**
      * Apply the Dijkstra algorithm to find all shortest paths to the given
      * graph node. The paths found can be extracted via Node's methods.
-     * Uses weights in nodes and links.
+     * Uses weights in nodes and links. Runs in O((V+E) log V) time, using
+     * an indexed binary heap with decrease-key.
      */
     void calculateWeightedSingleShortestPathsTo(Node *target);
 
@@ -513,6 +513,10 @@ void EtherMAC::startFrameTransmission()
     if (frame->getSrc().isUnspecified())
         frame->setSrc(address);
 
+    // reception times are only maintained by EtherMACFullDuplex
+    frame->setRxStartTime(-1);
+    frame->setRxEndTime(-1);
+
     bool inBurst = frameBursting && framesSentInBurst;
     int64 minFrameLength = duplexMode ? curEtherDescr->frameMinBytes : (inBurst ? curEtherDescr->frameInBurstMinBytes : curEtherDescr->halfDuplexFrameMinBytes);
 
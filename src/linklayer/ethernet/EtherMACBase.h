@@ -101,6 +101,7 @@ class INET_API EtherMACBase : public MACBase, public cListener
         InnerQueue(const char* name = NULL, int limit = 0) : queue(name, packetCompare), queueLimit(limit) {}
         void insertFrame(cObject *obj) { queue.insert(obj); }
         cObject *pop() { return queue.pop(); }
+        cObject *front() const { return queue.front(); }
         bool empty() const { return queue.empty(); }
         int getQueueLimit() const { return queueLimit; }
         bool isFull() const { return queueLimit != 0 && queue.length() > queueLimit; }
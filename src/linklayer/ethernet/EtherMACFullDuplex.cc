@@ -27,10 +27,28 @@
 // TODO: refactor using a statemachine that is present in a single function
 // TODO: this helps understanding what interactions are there and how they affect the state
 
+// the part of the frame a cut-through switch has to receive before forwarding it:
+// preamble, SFD, addresses and an 802.1Q tag (or EtherType)
+#define CUT_THROUGH_HEADER_BYTES  (PREAMBLE_BYTES+SFD_BYTES+6+6+4)
+
 Define_Module(EtherMACFullDuplex);
 
+simsignal_t EtherMACFullDuplex::forwardingDelaySignal = registerSignal("forwardingDelay");
+
 EtherMACFullDuplex::EtherMACFullDuplex()
 {
+    cutThrough = false;
+    curRxFrame = NULL;
+    endCutThroughRxMsg = NULL;
+    maxTrainLength = 1;
+}
+
+EtherMACFullDuplex::~EtherMACFullDuplex()
+{
+    delete curRxFrame;
+    cancelAndDelete(endCutThroughRxMsg);
+    for (std::vector<TrainFrame>::iterator it = txTrain.begin(); it != txTrain.end(); ++it)
+        delete it->frame;
 }
 
 void EtherMACFullDuplex::initialize(int stage)
@@ -42,6 +60,8 @@ void EtherMACFullDuplex::initialize(int stage)
         if (!par("duplexMode").boolValue())
             throw cRuntimeError("Half duplex operation is not supported by EtherMACFullDuplex, use the EtherMAC module for that! (Please enable csmacdSupport on EthernetInterface)");
 
+        endCutThroughRxMsg = new cMessage("EndCutThroughRx", ENDRECEPTION);
+
         beginSendFrames();
     }
 }
@@ -52,6 +72,8 @@ void EtherMACFullDuplex::initializeStatistics()
 
     // initialize statistics
     totalSuccessfulRxTime = 0.0;
+    numForwardedBitError = 0;
+    WATCH(numForwardedBitError);
 }
 
 void EtherMACFullDuplex::initializeFlags()
@@ -59,7 +81,14 @@ void EtherMACFullDuplex::initializeFlags()
     EtherMACBase::initializeFlags();
 
     duplexMode = true;
-    physInGate->setDeliverOnReceptionStart(false);
+
+    // in cut-through mode, frames arrive at the start of their reception, see processMsgFromNetwork()
+    cutThrough = par("cutThrough");
+    physInGate->setDeliverOnReceptionStart(cutThrough);
+
+    maxTrainLength = par("maxTrainLength");
+    if (maxTrainLength < 1)
+        throw cRuntimeError("Invalid maxTrainLength parameter: %d, must be at least 1", maxTrainLength);
 }
 
 void EtherMACFullDuplex::handleMessage(cMessage *msg)
@@ -96,6 +125,8 @@ void EtherMACFullDuplex::handleSelfMessage(cMessage *msg)
         handleEndIFGPeriod();
     else if (msg == endPauseMsg)
         handleEndPausePeriod();
+    else if (msg == endCutThroughRxMsg)
+        handleEndCutThroughRxPeriod();
     else
         throw cRuntimeError("Unknown self message received!");
 }
@@ -103,13 +134,80 @@ void EtherMACFullDuplex::handleSelfMessage(cMessage *msg)
 void EtherMACFullDuplex::startFrameTransmission()
 {
     ASSERT(curTxFrame);
+
+    // a frame with bit error that waited in the queue until its reception had
+    // ended is dropped here, like a store-and-forward switch would drop it
+    while (curTxFrame && isReceivedFrameWithBitError(curTxFrame))
+    {
+        dropFrameWithBitError(curTxFrame);
+        curTxFrame = NULL;
+        getNextFrameFromQueue();
+    }
+    if (!curTxFrame)
+    {
+        transmitState = TX_IDLE_STATE;
+        return;
+    }
+
+    if (curTxFrame->getRxEndTime() > simTime())
+    {
+        // the frame is being forwarded in cut-through mode: its transmission must
+        // not end before its reception at the input port does (no underrun)
+        int64 txBytes = std::max(curTxFrame->getByteLength(), curEtherDescr->frameMinBytes) + PREAMBLE_BYTES + SFD_BYTES;
+        simtime_t earliestStartTime = curTxFrame->getRxEndTime() - txBytes * 8 / curEtherDescr->txrate;
+        if (earliestStartTime > simTime())
+        {
+            EV << "Delaying cut-through transmission of " << curTxFrame << " until " << earliestStartTime << endl;
+            transmitState = WAIT_IFG_STATE;
+            scheduleAt(earliestStartTime, endIFGMsg);
+            return;
+        }
+    }
+
     EV << "Transmitting a copy of frame " << curTxFrame << endl;
+    transmitFrame(curTxFrame, 0);
+
+    // packet train: send further queued frames back-to-back right away, each one
+    // delayed to the end of the previous one plus the IFG, so they arrive at the
+    // same time as if they were sent one by one
+    if (txQueue.innerQueue)
+    {
+        while ((int)txTrain.size() + 1 < maxTrainLength && pauseUnitsRequested == 0 && !txQueue.innerQueue->empty())
+        {
+            EtherFrame *nextFrame = (EtherFrame *)txQueue.innerQueue->front();
+            if (nextFrame->getRxEndTime() > simTime())
+                break;  // still being received in cut-through mode, see above
+            txQueue.innerQueue->pop();
+            if (isReceivedFrameWithBitError(nextFrame))
+            {
+                dropFrameWithBitError(nextFrame);
+                continue;
+            }
+            simtime_t delay = transmissionChannel->getTransmissionFinishTime() - simTime() + INTERFRAME_GAP_BITS / curEtherDescr->txrate;
+            EV << "Transmitting a copy of frame " << nextFrame << " in packet train, " << delay << " from now" << endl;
+            EtherFrame *copy = transmitFrame(nextFrame, delay);
+            txTrain.push_back(TrainFrame(nextFrame, copy, simTime() + delay));
+        }
+    }
+
+    scheduleAt(transmissionChannel->getTransmissionFinishTime(), endTxMsg);
+    transmitState = TRANSMITTING_STATE;
+}
+
+EtherFrame *EtherMACFullDuplex::transmitFrame(EtherFrame *txFrame, simtime_t delay)
+{
+    if (txFrame->getRxStartTime() >= 0)
+        emit(forwardingDelaySignal, simTime() + delay - txFrame->getRxStartTime());
 
-    EtherFrame *frame = curTxFrame->dup();  // note: we need to duplicate the frame because we emit a signal with it in endTxPeriod()
+    EtherFrame *frame = txFrame->dup();  // note: we need to duplicate the frame because we emit a signal with it in endTxPeriod()
 
     if (frame->getSrc().isUnspecified())
         frame->setSrc(address);
 
+    // reception times are set again by the receiving MAC
+    frame->setRxStartTime(-1);
+    frame->setRxEndTime(-1);
+
     if (frame->getByteLength() < curEtherDescr->frameMinBytes)
         frame->setByteLength(curEtherDescr->frameMinBytes);
 
@@ -118,10 +216,11 @@ void EtherMACFullDuplex::startFrameTransmission()
 
     // send
     EV << "Starting transmission of " << frame << endl;
-    send(frame, physOutGate);
-
-    scheduleAt(transmissionChannel->getTransmissionFinishTime(), endTxMsg);
-    transmitState = TRANSMITTING_STATE;
+    if (delay == 0)
+        send(frame, physOutGate);
+    else
+        sendDelayed(frame, delay, physOutGate);
+    return frame;
 }
 
 void EtherMACFullDuplex::processFrameFromUpperLayer(EtherFrame *frame)
@@ -221,12 +320,44 @@ void EtherMACFullDuplex::processMsgFromNetwork(EtherTraffic *msg)
 
     totalSuccessfulRxTime += frame->getDuration();
 
-    // bit errors
-    if (frame->hasBitError())
+    if (cutThrough)
     {
-        numDroppedBitError++;
-        emit(dropPkBitErrorSignal, frame);
-        delete frame;
+        // the frame arrived at the start of its reception: process data frames when
+        // their header has arrived, other frames when they have arrived completely
+        frame->setRxStartTime(simTime());
+        frame->setRxEndTime(simTime() + frame->getDuration());
+        simtime_t delay = isCutThroughFrame(frame) ? CUT_THROUGH_HEADER_BYTES * 8 / curEtherDescr->txrate : frame->getDuration();
+        ASSERT(curRxFrame == NULL);
+        curRxFrame = frame;
+        scheduleAt(simTime() + delay, endCutThroughRxMsg);
+        return;
+    }
+
+    frame->setRxStartTime(simTime() - frame->getDuration());
+    frame->setRxEndTime(simTime());
+    processReceivedFrame(frame);
+}
+
+bool EtherMACFullDuplex::isCutThroughFrame(EtherFrame *frame)
+{
+    // frames to the reserved 01-80-C2-00-00-0x group addresses (PAUSE, BPDU, etc.) are never forwarded
+    return (frame->getDest().getInt() & ~(uint64)0xF) != 0x0180C2000000ULL;
+}
+
+void EtherMACFullDuplex::handleEndCutThroughRxPeriod()
+{
+    EtherFrame *frame = curRxFrame;
+    curRxFrame = NULL;
+    processReceivedFrame(frame);
+}
+
+void EtherMACFullDuplex::processReceivedFrame(EtherFrame *frame)
+{
+    // bit errors; in cut-through mode the FCS may not have been received yet,
+    // then the frame is passed up anyway (see processReceivedDataFrame())
+    if (isReceivedFrameWithBitError(frame))
+    {
+        dropFrameWithBitError(frame);
         return;
     }
 
@@ -247,6 +378,19 @@ void EtherMACFullDuplex::processMsgFromNetwork(EtherTraffic *msg)
     }
 }
 
+bool EtherMACFullDuplex::isReceivedFrameWithBitError(EtherFrame *frame)
+{
+    return frame->hasBitError() && frame->getRxEndTime() <= simTime();
+}
+
+void EtherMACFullDuplex::dropFrameWithBitError(EtherFrame *frame)
+{
+    EV << "Dropping frame " << frame << " with bit error\n";
+    numDroppedBitError++;
+    emit(dropPkBitErrorSignal, frame);
+    delete frame;
+}
+
 void EtherMACFullDuplex::handleEndIFGPeriod()
 {
     if (transmitState != WAIT_IFG_STATE)
@@ -267,24 +411,14 @@ void EtherMACFullDuplex::handleEndTxPeriod()
     if (NULL == curTxFrame)
         error("Frame under transmission cannot be found");
 
-    emit(packetSentToLowerSignal, curTxFrame);  //consider: emit with start time of frame
+    processTransmittedFrame(curTxFrame);
+    curTxFrame = NULL;
 
-    if (dynamic_cast<EtherPauseFrame*>(curTxFrame) != NULL)
-    {
-        numPauseFramesSent++;
-        emit(txPausePkUnitsSignal, ((EtherPauseFrame*)curTxFrame)->getPauseTime());
-    }
-    else
-    {
-        unsigned long curBytes = curTxFrame->getFrameByteLength();
-        numFramesSent++;
-        numBytesSent += curBytes;
-        emit(txPkSignal, curTxFrame);
-    }
+    // frames of the train were transmitted back-to-back after curTxFrame
+    for (std::vector<TrainFrame>::iterator it = txTrain.begin(); it != txTrain.end(); ++it)
+        processTransmittedFrame(it->frame);
+    txTrain.clear();
 
-    EV << "Transmission of " << curTxFrame << " successfully completed\n";
-    delete curTxFrame;
-    curTxFrame = NULL;
     lastTxFinishTime = simTime();
     getNextFrameFromQueue();
 
@@ -303,10 +437,34 @@ void EtherMACFullDuplex::handleEndTxPeriod()
     }
 }
 
+void EtherMACFullDuplex::processTransmittedFrame(EtherFrame *frame)
+{
+    emit(packetSentToLowerSignal, frame);  //consider: emit with start time of frame
+
+    if (dynamic_cast<EtherPauseFrame*>(frame) != NULL)
+    {
+        numPauseFramesSent++;
+        emit(txPausePkUnitsSignal, ((EtherPauseFrame*)frame)->getPauseTime());
+    }
+    else
+    {
+        unsigned long curBytes = frame->getFrameByteLength();
+        numFramesSent++;
+        numBytesSent += curBytes;
+        emit(txPkSignal, frame);
+    }
+
+    EV << "Transmission of " << frame << " successfully completed\n";
+    delete frame;
+}
+
 void EtherMACFullDuplex::finish()
 {
     EtherMACBase::finish();
 
+    if (cutThrough)
+        recordScalar("frames forwarded with bit error", numForwardedBitError);
+
     simtime_t t = simTime();
     simtime_t totalRxChannelIdleTime = t - totalSuccessfulRxTime;
     recordScalar("rx channel idle (%)", 100 * (totalRxChannelIdleTime / t));
@@ -329,11 +487,17 @@ void EtherMACFullDuplex::processReceivedDataFrame(EtherFrame *frame)
     // strip physical layer overhead (preamble, SFD) from frame
     frame->setByteLength(frame->getFrameByteLength());
 
-    // statistics
-    unsigned long curBytes = frame->getByteLength();
-    numFramesReceivedOK++;
-    numBytesReceivedOK += curBytes;
-    emit(rxPkOkSignal, frame);
+    // statistics; a frame with bit error gets here only in cut-through mode,
+    // before its FCS has been received: the next store-and-forward hop drops it
+    if (frame->hasBitError())
+        numForwardedBitError++;
+    else
+    {
+        unsigned long curBytes = frame->getByteLength();
+        numFramesReceivedOK++;
+        numBytesReceivedOK += curBytes;
+        emit(rxPkOkSignal, frame);
+    }
 
     numFramesPassedToHL++;
     emit(packetSentToUpperSignal, frame);
@@ -341,6 +505,46 @@ void EtherMACFullDuplex::processReceivedDataFrame(EtherFrame *frame)
     send(frame, "upperLayerOut");
 }
 
+void EtherMACFullDuplex::processConnectDisconnect()
+{
+    if (!connected)
+    {
+        cancelEvent(endCutThroughRxMsg);
+        if (curRxFrame)
+        {
+            numDroppedIfaceDown++;
+            emit(dropPkIfaceDownSignal, curRxFrame);
+            delete curRxFrame;
+            curRxFrame = NULL;
+        }
+
+        // curTxFrame is deleted by EtherMACBase, the rest of the train here. The frame
+        // under transmission still reaches the peer, but the train is cut: the copies
+        // whose transmission has not started yet cannot have arrived, so they are
+        // taken back from the FES and dropped like the frames in the queue
+        bool cut = false;
+        for (std::vector<TrainFrame>::iterator it = txTrain.begin(); it != txTrain.end(); ++it)
+        {
+            if (it->txStartTime > simTime())
+            {
+                delete simulation.msgQueue.remove(it->copy);
+                EV << "Interface is not connected, dropping packet " << it->frame << endl;
+                numDroppedPkFromHLIfaceDown++;
+                emit(dropPkIfaceDownSignal, it->frame);
+                cut = true;
+            }
+            delete it->frame;
+        }
+        txTrain.clear();
+
+        // the channel was reserved until the end of the train
+        if (cut && transmissionChannel)
+            transmissionChannel->forceTransmissionFinishTime(SIMTIME_ZERO);
+    }
+
+    EtherMACBase::processConnectDisconnect();
+}
+
 void EtherMACFullDuplex::processPauseCommand(int pauseUnits)
 {
     if (transmitState == TX_IDLE_STATE)
@@ -18,6 +18,8 @@
 #ifndef __INET_ETHER_DUPLEX_MAC_H
 #define __INET_ETHER_DUPLEX_MAC_H
 
+#include <vector>
+
 #include "INETDefs.h"
 
 #include "EtherMACBase.h"
@@ -32,6 +34,7 @@ class INET_API EtherMACFullDuplex : public EtherMACBase
 {
   public:
     EtherMACFullDuplex();
+    virtual ~EtherMACFullDuplex();
 
   protected:
     virtual void initialize(int stage);
@@ -47,17 +50,43 @@ class INET_API EtherMACFullDuplex : public EtherMACBase
     virtual void handleEndTxPeriod();
     virtual void handleEndPausePeriod();
     virtual void handleSelfMessage(cMessage *msg);
+    virtual void handleEndCutThroughRxPeriod();
 
     // helpers
     virtual void startFrameTransmission();
+    virtual EtherFrame *transmitFrame(EtherFrame *frame, simtime_t delay);
+    virtual void processTransmittedFrame(EtherFrame *frame);
     virtual void processFrameFromUpperLayer(EtherFrame *frame);
     virtual void processMsgFromNetwork(EtherTraffic *msg);
+    virtual void processReceivedFrame(EtherFrame *frame);
     virtual void processReceivedDataFrame(EtherFrame *frame);
     virtual void processPauseCommand(int pauseUnits);
     virtual void scheduleEndIFGPeriod();
     virtual void scheduleEndPausePeriod(int pauseUnits);
     virtual void beginSendFrames();
+    virtual void processConnectDisconnect();
+    virtual bool isCutThroughFrame(EtherFrame *frame);
+    virtual bool isReceivedFrameWithBitError(EtherFrame *frame);
+    virtual void dropFrameWithBitError(EtherFrame *frame);
+
+    // cut-through forwarding
+    bool cutThrough;                // pass data frames up as soon as their header has been received
+    EtherFrame *curRxFrame;         // frame under reception in cut-through mode, waiting for its header or end
+    cMessage *endCutThroughRxMsg;
+    unsigned long numForwardedBitError; // frames passed up in cut-through mode that turned out to have bit errors
+
+    static simsignal_t forwardingDelaySignal;
 
+    // packet trains
+    struct TrainFrame
+    {
+        EtherFrame *frame;          // deleted at the end of the train
+        EtherFrame *copy;           // sent with sendDelayed(), in the FES until its transmission starts at txStartTime
+        simtime_t txStartTime;
+        TrainFrame(EtherFrame *frame, EtherFrame *copy, simtime_t txStartTime) : frame(frame), copy(copy), txStartTime(txStartTime) {}
+    };
+    int maxTrainLength;             // max number of queued frames sent back-to-back with a single end-of-transmission event
+    std::vector<TrainFrame> txTrain;    // frames following curTxFrame in the train under transmission
 
     // statistics
     simtime_t totalSuccessfulRxTime; // total duration of successful transmissions on channel
@@ -14,24 +14,21 @@
 // along with this program.  If not, see http://www.gnu.org/licenses/.
 // 
 
-#include <map>
 #include "MACAddressTable.h"
 
 #define MAX_LINE 100
+#define INITIAL_SIZE  64
 
 Define_Module(MACAddressTable);
 
 std::ostream& operator<<(std::ostream& os, const MACAddressTable::AddressEntry& entry)
 {
-    os << "{VID=" << entry.vid << ", port=" << entry.portno << ", insertionTime=" << entry.insertionTime << "}";
+    os << "{VID=" << entry.vid << ", MAC=" << entry.address << ", port=" << entry.portno << ", insertionTime=" << entry.insertionTime << "}";
     return os;
 }
 
-MACAddressTable::MACAddressTable()
+MACAddressTable::MACAddressTable() : entryIndices(INITIAL_SIZE), oldestEntry(-1), newestEntry(-1)
 {
-    addressTable = new AddressTable();
-    // Set addressTable for VLAN ID 0
-    vlanAddressTable[0] = addressTable;
 }
 
 void MACAddressTable::initialize()
@@ -44,8 +41,7 @@ void MACAddressTable::initialize()
     if (addressTableFile && *addressTableFile)
         readAddressTable(addressTableFile);
 
-    AddressTable& addressTable = *this->addressTable; // magic to hide the '*' from the name of the watch below
-    WATCH_MAP(addressTable);
+    WATCH_VECTOR(entries);
 }
 
 /**
@@ -79,22 +75,89 @@ void MACAddressTable::handleMessage(cMessage *)
     throw cRuntimeError("This module doesn't process messages");
 }
 
-/*
- * getTableForVid
- * Returns a MAC Address Table for a specified VLAN ID
- * or NULL pointer if it is not found
- */
+uint32 MACAddressTable::VlanAddressHash::operator()(const VlanAddress& key) const
+{
+    // multiplicative hashing of the 48-bit address and the VLAN ID
+    uint64 h = key.address.getInt() ^ ((uint64)key.vid << 48);
+    h *= 0x9e3779b97f4a7c15ULL;
+    return (uint32)(h >> 32);
+}
+
+int MACAddressTable::findEntry(const MACAddress& address, unsigned int vid) const
+{
+    const int *index = entryIndices.find(VlanAddress(vid, address));
+    return index ? *index : -1;
+}
+
+void MACAddressTable::linkEntry(int index)
+{
+    AddressEntry& entry = entries[index];
+    entry.prev = newestEntry;
+    entry.next = -1;
+    if (newestEntry != -1)
+        entries[newestEntry].next = index;
+    else
+        oldestEntry = index;
+    newestEntry = index;
+}
+
+void MACAddressTable::unlinkEntry(int index)
+{
+    AddressEntry& entry = entries[index];
+    if (entry.prev != -1)
+        entries[entry.prev].next = entry.next;
+    else
+        oldestEntry = entry.next;
+    if (entry.next != -1)
+        entries[entry.next].prev = entry.prev;
+    else
+        newestEntry = entry.prev;
+    entry.prev = entry.next = -1;
+}
+
+void MACAddressTable::addEntry(const MACAddress& address, unsigned int vid, int portno)
+{
+    ASSERT(findEntry(address, vid) == -1);
+    entryIndices.insert(VlanAddress(vid, address), entries.size());
+    entries.push_back(AddressEntry(vid, address, portno, simTime()));
+    linkEntry(entries.size() - 1);
+}
+
+void MACAddressTable::touchEntry(int index)
+{
+    // the current time is not less than any insertionTime, so the entry goes to the end of the list
+    entries[index].insertionTime = simTime();
+    if (index != newestEntry)
+    {
+        unlinkEntry(index);
+        linkEntry(index);
+    }
+}
 
-MACAddressTable::AddressTable * MACAddressTable::getTableForVid(unsigned int vid)
+void MACAddressTable::removeEntry(int index)
 {
-    if (vid == 0)
-        return addressTable;
-
-    MACAddressTable::VlanAddressTable::iterator iter;
-    iter = vlanAddressTable.find(vid);
-    if (iter != vlanAddressTable.end())
-        return iter->second;
-    return NULL;
+    AddressEntry& entry = entries[index];
+    ASSERT(findEntry(entry.address, entry.vid) == index);
+    unlinkEntry(index);
+    entryIndices.remove(VlanAddress(entry.vid, entry.address));
+
+    // keep entries contiguous: move the last entry into the freed index
+    int last = entries.size() - 1;
+    if (index != last)
+    {
+        AddressEntry& moved = entries[last];
+        *entryIndices.find(VlanAddress(moved.vid, moved.address)) = index;
+        if (moved.prev != -1)
+            entries[moved.prev].next = index;
+        else
+            oldestEntry = index;
+        if (moved.next != -1)
+            entries[moved.next].prev = index;
+        else
+            newestEntry = index;
+        entries[index] = moved;
+    }
+    entries.pop_back();
 }
 
 /*
@@ -107,26 +170,21 @@ int MACAddressTable::getPortForAddress(MACAddress& address, unsigned int vid)
 {
     Enter_Method("MACAddressTable::getPortForAddress()");
 
-    AddressTable * table = getTableForVid(vid);
-    // VLAN ID vid does not exist
-    if (table == NULL)
-        return -1;
-
-    AddressTable::iterator iter = table->find(address);
-
-    if (iter == table->end())
+    int index = findEntry(address, vid);
+    if (index == -1)
     {
         // not found
         return -1;
     }
-    if (iter->second.insertionTime + agingTime <= simTime())
+    AddressEntry& entry = entries[index];
+    if (isAged(entry))
     {
         // don't use (and throw out) aged entries
-        EV<< "Ignoring and deleting aged entry: "<< iter->first << " --> port" << iter->second.portno << "\n";
-        table->erase(iter);
+        EV<< "Ignoring and deleting aged entry: "<< entry.address << " --> port" << entry.portno << "\n";
+        removeEntry(index);
         return -1;
     }
-    return iter->second.portno;
+    return entry.portno;
 }
 
 /*
@@ -140,40 +198,22 @@ bool MACAddressTable::updateTableWithAddress(int portno, MACAddress& address, un
     if (address.isBroadcast())
         return false;
 
-    AddressTable::iterator iter;
-    AddressTable * table = getTableForVid(vid);
-
-    if (table == NULL)
-    {
-        // MAC Address Table does not exist for VLAN ID vid, so we create it
-        table = new AddressTable();
-
-        // set 'the addressTable' to VLAN ID 0
-        if (vid == 0)
-            addressTable = table;
-
-        vlanAddressTable[vid] = table;
-        iter = table->end();
-    }
-    else
-        iter = table->find(address);
-
-    if (iter == table->end())
+    int index = findEntry(address, vid);
+    if (index == -1)
     {
         removeAgedEntriesIfNeeded();
 
         // Add entry to table
         EV<< "Adding entry to Address Table: "<< address << " --> port" << portno << "\n";
-        (*table)[address] = AddressEntry(vid,portno,simTime());
+        addEntry(address, vid, portno);
         return false;
     }
     else
     {
         // Update existing entry
         EV << "Updating entry in Address Table: "<< address << " --> port" << portno << "\n";
-        AddressEntry& entry = iter->second;
-        entry.insertionTime = simTime();
-        entry.portno = portno;
+        entries[index].portno = portno;
+        touchEntry(index);
     }
     return true;
 }
@@ -185,17 +225,10 @@ bool MACAddressTable::updateTableWithAddress(int portno, MACAddress& address, un
 void MACAddressTable::flush(int portno)
 {
     Enter_Method("MACAddressTable::flush():  Clearing gate %d cache", portno);
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
-    {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end();)
-        {
-            AddressTable::iterator cur = j++;
-            if (cur->second.portno == portno)
-                table->erase(cur);
-        }
-
-    }
+    // backwards, because removeEntry() moves the last entry to the removed one's index
+    for (int i = entries.size() - 1; i >= 0; i--)
+        if (entries[i].portno == portno)
+            removeEntry(i);
 }
 /*
  * Prints verbose information
@@ -205,62 +238,44 @@ void MACAddressTable::printState()
 {
     EV<< endl << "MAC Address Table" << endl;
     EV << "VLAN ID    MAC    Port    Inserted" << endl;
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
-    {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end(); j++)
-        EV << j->second.vid << "   " << j->first << "   " << j->second.portno << "   " << j->second.insertionTime << endl;
-    }
-
+    for (int i = oldestEntry; i != -1; i = entries[i].next)
+        EV << entries[i].vid << "   " << entries[i].address << "   " << entries[i].portno << "   " << entries[i].insertionTime << endl;
 }
 
 void MACAddressTable::copyTable(int portA, int portB)
 {
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
-    {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end(); j++)
-            if (j->second.portno == portA)
-                j->second.portno = portB;
-    }
+    for (std::vector<AddressEntry>::iterator it = entries.begin(); it != entries.end(); it++)
+        if (it->portno == portA)
+            it->portno = portB;
 }
 
 void MACAddressTable::removeAgedEntriesFromVlan(unsigned int vid)
 {
-    AddressTable * table = getTableForVid(vid);
-    if (table == NULL)
-        return;
-    // TODO: this part could be factored out
-    for (AddressTable::iterator iter = table->begin(); iter != table->end();)
+    // aged entries are at the front of the aging list
+    for (int i = oldestEntry; i != -1 && isAged(entries[i]); )
     {
-        AddressTable::iterator cur = iter++; // iter will get invalidated after erase()
-        AddressEntry& entry = cur->second;
-        if (entry.insertionTime + agingTime <= simTime())
+        int next = entries[i].next;
+        if (entries[i].vid == vid)
         {
             EV<< "Removing aged entry from Address Table: " <<
-            cur->first << " --> port" << cur->second.portno << "\n";
-            table->erase(cur);
+            entries[i].address << " --> port" << entries[i].portno << "\n";
+            int last = entries.size() - 1;
+            removeEntry(i);
+            if (next == last)
+                next = i;   // the last entry was moved to index i
         }
+        i = next;
     }
 }
 
 void MACAddressTable::removeAgedEntriesFromAllVlans()
 {
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
+    // aged entries are at the front of the aging list
+    while (oldestEntry != -1 && isAged(entries[oldestEntry]))
     {
-        AddressTable * table = i->second;
-        // TODO: this part could be factored out
-        for (AddressTable::iterator j = table->begin(); j != table->end();)
-        {
-            AddressTable::iterator cur = j++; // iter will get invalidated after erase()
-            AddressEntry& entry = cur->second;
-            if (entry.insertionTime + agingTime <= simTime())
-            {
-                EV<< "Removing aged entry from Address Table: " <<
-                cur->first << " --> port" << cur->second.portno << "\n";
-                table->erase(cur);
-            }
-        }
+        EV<< "Removing aged entry from Address Table: " <<
+        entries[oldestEntry].address << " --> port" << entries[oldestEntry].portno << "\n";
+        removeEntry(oldestEntry);
     }
 }
 
@@ -316,16 +331,13 @@ void MACAddressTable::readAddressTable(const char* fileName)
             error("line %d invalid in address table file `%s'", lineno, fileName);
 
         // Create an entry with address and portno and insert into table
-        AddressEntry entry(atoi(vlanID), atoi(portno), 0);
-        AddressTable * table = getTableForVid(entry.vid);
-
-        if(table == NULL)
-        {
-            table = new AddressTable();
-            vlanAddressTable[entry.vid] = table;
-        }
-
-        (*table)[MACAddress(hexaddress)] = entry;
+        // (insertion time is the current time, i.e. 0 during initialization)
+        MACAddress address(hexaddress);
+        int index = findEntry(address, atoi(vlanID));
+        if (index == -1)
+            addEntry(address, atoi(vlanID), atoi(portno));
+        else
+            entries[index].portno = atoi(portno);
 
         // Garbage collection before next iteration
         delete [] line;
@@ -335,18 +347,11 @@ void MACAddressTable::readAddressTable(const char* fileName)
 
 void MACAddressTable::clearTable()
 {
-    for (VlanAddressTable::iterator iter = vlanAddressTable.begin(); iter != vlanAddressTable.end(); iter++)
-        delete iter->second;
-
-    vlanAddressTable.clear();
-    addressTable = NULL;
+    entries.clear();
+    entryIndices.clear();
+    oldestEntry = newestEntry = -1;
 }
 
-MACAddressTable::~MACAddressTable()
-{
-    for (VlanAddressTable::iterator iter = vlanAddressTable.begin(); iter != vlanAddressTable.end(); iter++)
-        delete iter->second;
-}
 void MACAddressTable::setAgingTime(simtime_t agingTime)
 {
     this->agingTime = agingTime;
@@ -17,11 +17,21 @@
 #ifndef __INET_MACADDRESSTABLE_H_
 #define __INET_MACADDRESSTABLE_H_
 
+#include <vector>
+
 #include "MACAddress.h"
 #include "IMACAddressTable.h"
+#include "OpenAddressingTable.h"
 
 /**
  * This module handles the mapping between ports and MAC addresses. See the NED definition for details.
+ *
+ * Entries of all VLANs are indexed by one OpenAddressingTable keyed by
+ * (VLAN ID, MAC address), so learning and lookup take O(1).
+ * Since an entry's insertion time is always set to the current simulation
+ * time, the entries are also kept on a doubly linked list in the order of
+ * their insertion time; aged entries are at the front of the list, and
+ * removing them costs time proportional to their number.
  */
 class MACAddressTable : public cSimpleModule, public IMACAddressTable
 {
@@ -29,27 +39,37 @@ class MACAddressTable : public cSimpleModule, public IMACAddressTable
         struct AddressEntry
         {
                 unsigned int vid;           // VLAN ID
+                MACAddress address;
                 int portno;                 // Input port
                 simtime_t insertionTime;    // Arrival time of Lookup Address Table entry
-                AddressEntry() : vid(0) { }
-                AddressEntry(unsigned int vid, int portno, simtime_t insertionTime) :
-                        vid(vid), portno(portno), insertionTime(insertionTime) { }
+                int prev;                   // neighbors on the aging list (indices into entries, -1 if none)
+                int next;
+                AddressEntry() : vid(0), portno(-1), prev(-1), next(-1) { }
+                AddressEntry(unsigned int vid, const MACAddress& address, int portno, simtime_t insertionTime) :
+                        vid(vid), address(address), portno(portno), insertionTime(insertionTime), prev(-1), next(-1) { }
         };
         friend std::ostream& operator<<(std::ostream& os, const AddressEntry& entry);
 
-        struct MAC_compare
+        struct VlanAddress
         {
-            bool operator()(const MACAddress& u1, const MACAddress& u2) const {return u1.compareTo(u2) < 0;}
+                unsigned int vid;
+                MACAddress address;
+                VlanAddress() : vid(0) { }
+                VlanAddress(unsigned int vid, const MACAddress& address) : vid(vid), address(address) { }
+                bool operator==(const VlanAddress& other) const { return vid == other.vid && address == other.address; }
         };
 
-
-        typedef std::map<MACAddress, AddressEntry, MAC_compare> AddressTable;
-        typedef std::map<unsigned int, AddressTable*> VlanAddressTable;
+        struct VlanAddressHash
+        {
+                uint32 operator()(const VlanAddress& key) const;
+        };
 
         simtime_t agingTime;                // Max idle time for address table entries
         simtime_t lastPurge;                // Time of the last call of removeAgedEntriesFromAllVlans()
-        AddressTable * addressTable;        // VLAN-unaware address lookup (vid = 0)
-        VlanAddressTable vlanAddressTable;  // VLAN-aware address lookup
+        std::vector<AddressEntry> entries;  // address entries of all VLANs, in no particular order
+        OpenAddressingTable<VlanAddress, int, VlanAddressHash> entryIndices;   // indices into entries
+        int oldestEntry;                    // head of the aging list (ascending insertionTime), -1 if empty
+        int newestEntry;                    // tail of the aging list
 
     protected:
 
@@ -57,14 +77,32 @@ class MACAddressTable : public cSimpleModule, public IMACAddressTable
         virtual void handleMessage(cMessage *msg);
 
         /**
-         * @brief Returns a MAC Address Table for a specified VLAN ID
+         * @brief Returns the index of the entry for address in VLAN vid, or -1
+         */
+        int findEntry(const MACAddress& address, unsigned int vid) const;
+
+        /**
+         * @brief Adds an entry with the current simulation time; the address must not be in the table
          */
-        AddressTable * getTableForVid(unsigned int vid);
+        void addEntry(const MACAddress& address, unsigned int vid, int portno);
+
+        /**
+         * @brief Removes an entry; the last entry of the vector takes its index
+         */
+        void removeEntry(int index);
+
+        /**
+         * @brief Moves an entry to the end of the aging list, after its insertionTime was set to the current time
+         */
+        void touchEntry(int index);
+
+        void linkEntry(int index);
+        void unlinkEntry(int index);
+        bool isAged(const AddressEntry& entry) const { return entry.insertionTime + agingTime <= simTime(); }
 
     public:
 
         MACAddressTable();
-        ~MACAddressTable();
 
     public:
         // Table management
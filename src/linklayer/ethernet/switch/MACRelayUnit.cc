@@ -109,10 +109,22 @@ void MACRelayUnit::handleAndDispatchFrame(EtherFrame *frame)
 
 void MACRelayUnit::broadcastFrame(EtherFrame *frame, int inputport)
 {
+    // copies share the encapsulated packet with the original (see cPacket::dup()),
+    // and the original itself goes out on the last port instead of being deleted
+    int pendingPort = -1;
     for (int i=0; i<numPorts; ++i)
+    {
         if (i != inputport)
-            send((EtherFrame*)frame->dup(), "ifOut", i);
-    delete frame;
+        {
+            if (pendingPort != -1)
+                send((EtherFrame*)frame->dup(), "ifOut", pendingPort);
+            pendingPort = i;
+        }
+    }
+    if (pendingPort != -1)
+        send(frame, "ifOut", pendingPort);
+    else
+        delete frame;
 }
 
 void MACRelayUnit::start()
@@ -23,6 +23,7 @@
 #include "FWMath.h"
 #include "yans-error-rate-model.h"
 #include "nist-error-rate-model.h"
+#include "table-error-rate-model.h"
 #define NS3CALMODE
 
 
@@ -66,6 +67,9 @@ void Ieee80211RadioModel::initializeFrom(cModule *radioModule)
     else
         opp_error("Error %s model is not valid",radioModule->par("errorModel").stringValue());
 
+    if (radioModule->par("useErrorRateTable").boolValue())
+        errorModel = new TableErrorRateModel(errorModel, radioModule->par("errorRateTableMaxError").doubleValue());
+
 
     btSize = radioModule->par("btSize").longValue();
     autoHeaderSize = radioModule->par("AutoHeaderSize");
@@ -129,14 +133,8 @@ double Ieee80211RadioModel::calculateDuration(AirFrame *airframe)
 }
 
 
-PhyIndication Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList& receivedList)
+PhyIndication Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, double snirMin)
 {
-    // calculate snirMin
-    double snirMin = receivedList.begin()->snr;
-    for (SnrList::const_iterator iter = receivedList.begin(); iter != receivedList.end(); iter++)
-        if (iter->snr < snirMin)
-            snirMin = iter->snr;
-
     cPacket *frame = airframe->getEncapsulatedPacket();
     EV << "packet (" << frame->getClassName() << ")" << frame->getName() << " (" << frame->info() << ") snrMin=" << snirMin << endl;
 
@@ -58,7 +58,7 @@ class INET_API Ieee80211RadioModel : public IRadioModel
 
     virtual double calculateDuration(AirFrame *airframe);
 
-    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, const SnrList& receivedList);
+    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, double snirMin);
     ~Ieee80211RadioModel();
 
     // used by the Airtime Link Metric computation
@@ -0,0 +1,183 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <float.h>
+#include <limits>
+#include <typeinfo>
+
+#include "table-error-rate-model.h"
+
+// tabulated SNR range, in dB
+#define MIN_SNR_DB     -20.0
+#define MAX_SNR_DB     60.0
+
+// grid resolution, in dB
+#define INITIAL_STEP   0.5
+#define MIN_STEP       (1.0 / 64)
+
+std::map<TableErrorRateModel::TableKey, TableErrorRateModel::Table> TableErrorRateModel::tables;
+
+static bool isFinite(double x)
+{
+    return fabs(x) <= DBL_MAX;     // false for infinities and NaN
+}
+
+TableErrorRateModel::ModeKey::ModeKey(const ModulationType& mode)
+{
+    modulationClass = mode.getModulationClass();
+    constellationSize = mode.getConstellationSize();
+    codeRate = mode.getCodeRate();
+    dataRate = mode.getDataRate();
+    phyRate = mode.getPhyRate();
+    bandwidth = mode.getBandwidth();
+}
+
+bool TableErrorRateModel::ModeKey::operator<(const ModeKey& other) const
+{
+    if (modulationClass != other.modulationClass)
+        return modulationClass < other.modulationClass;
+    if (constellationSize != other.constellationSize)
+        return constellationSize < other.constellationSize;
+    if (codeRate != other.codeRate)
+        return codeRate < other.codeRate;
+    if (dataRate != other.dataRate)
+        return dataRate < other.dataRate;
+    if (phyRate != other.phyRate)
+        return phyRate < other.phyRate;
+    return bandwidth < other.bandwidth;
+}
+
+bool TableErrorRateModel::TableKey::operator<(const TableKey& other) const
+{
+    if (modelName != other.modelName)
+        return modelName < other.modelName;
+    if (maxError != other.maxError)
+        return maxError < other.maxError;
+    return mode < other.mode;
+}
+
+TableErrorRateModel::TableErrorRateModel(IErrorModel *model, double maxError) :
+    model(model), maxError(maxError)
+{
+    if (!(maxError > 0))
+        throw cRuntimeError("TableErrorRateModel: maxError must be positive");
+    modelName = opp_typename(typeid(*model));
+}
+
+TableErrorRateModel::~TableErrorRateModel()
+{
+    delete model;
+}
+
+double TableErrorRateModel::getExactValue(const ModulationType& mode, double snrDb) const
+{
+    double s = model->GetChunkSuccessRate(mode, pow(10.0, snrDb / 10), 1);
+    if (s == 1)
+        return -HUGE_VAL;
+    if (s == 0)
+        return HUGE_VAL;
+    if (!(s > 0 && s < 1))
+        return std::numeric_limits<double>::quiet_NaN();   // not a probability (e.g. DQPSK at very low SNR), use the analytic model here
+    return log(-log(s));
+}
+
+void TableErrorRateModel::buildTable(const ModulationType& mode, Table& table) const
+{
+    table.minSnrDb = MIN_SNR_DB;
+    table.step = INITIAL_STEP;
+    std::vector<double>& values = table.values;
+    int n = (int)((MAX_SNR_DB - MIN_SNR_DB) / INITIAL_STEP) + 1;
+    values.resize(n);
+    for (int i = 0; i < n; i++)
+        values[i] = getExactValue(mode, table.minSnrDb + i * table.step);
+
+    // halve the step until the interpolated values are accurate enough at
+    // the midpoints; the midpoints become the new entries
+    std::vector<double> refined;
+    std::vector<int> inaccurateCells;
+    while (true)
+    {
+        n = values.size();
+        refined.resize(2 * n - 1);
+        inaccurateCells.clear();
+        for (int i = 0; i < n - 1; i++)
+        {
+            double mid = getExactValue(mode, table.minSnrDb + (i + 0.5) * table.step);
+            refined[2 * i] = values[i];
+            refined[2 * i + 1] = mid;
+            if (isFinite(values[i]) && isFinite(values[i + 1]))
+            {
+                // relative error of -ln(s)
+                if (!isFinite(mid) || fabs(exp((values[i] + values[i + 1]) / 2 - mid) - 1) > maxError)
+                    inaccurateCells.push_back(i);
+            }
+        }
+        refined[2 * n - 2] = values[n - 1];
+
+        if (inaccurateCells.empty())
+            break;
+        if (table.step <= MIN_STEP)
+        {
+            // cells at discontinuities or sharp bends of the analytic model:
+            // NaN entries make lookups in these cells fall back to the analytic model
+            for (int k = 0; k < (int)inaccurateCells.size(); k++)
+                values[inaccurateCells[k]] = values[inaccurateCells[k] + 1] = std::numeric_limits<double>::quiet_NaN();
+            break;
+        }
+        values.swap(refined);
+        table.step /= 2;
+    }
+}
+
+const TableErrorRateModel::Table *TableErrorRateModel::getTable(const ModulationType& mode) const
+{
+    ModeKey modeKey(mode);
+    std::map<ModeKey, const Table *>::iterator it = cache.find(modeKey);
+    if (it != cache.end())
+        return it->second;
+
+    TableKey key(modelName, maxError, modeKey);
+    std::map<TableKey, Table>::iterator jt = tables.find(key);
+    if (jt == tables.end())
+    {
+        Table table;
+        buildTable(mode, table);
+        jt = tables.insert(std::make_pair(key, table)).first;
+    }
+    cache[modeKey] = &jt->second;
+    return &jt->second;
+}
+
+double TableErrorRateModel::GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const
+{
+    const Table *table = getTable(mode);
+    if (snr > 0)
+    {
+        double x = (10 * log10(snr) - table->minSnrDb) / table->step;
+        if (x >= 0 && x < table->values.size() - 1)
+        {
+            int i = (int)x;
+            double y0 = table->values[i];
+            double y1 = table->values[i + 1];
+            if (isFinite(y0) && isFinite(y1))
+                return exp(-(double)nbits * exp(y0 + (x - i) * (y1 - y0)));
+            if (y0 == y1)
+                return (y0 < 0 || nbits == 0) ? 1.0 : 0.0;  // no bit errors / all bits wrong in the whole cell
+        }
+    }
+    return model->GetChunkSuccessRate(mode, snr, nbits);
+}
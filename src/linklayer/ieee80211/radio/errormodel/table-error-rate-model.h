@@ -0,0 +1,108 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef TABLE_ERROR_RATE_MODEL_H
+#define TABLE_ERROR_RATE_MODEL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "WifiMode.h"
+#include "IErrorModel.h"
+
+/**
+ * Table driven version of an analytic error rate model (NistErrorRateModel,
+ * YansErrorRateModel). All of those compute the chunk success rate as
+ * s(snr)^nbits, where s is the success rate of a single bit, so it is enough
+ * to tabulate s over the SNR for each modulation; a lookup then costs a log10()
+ * and two exp() calls instead of the erfc/pow series of the analytic model.
+ *
+ * The table stores ln(-ln(s)) (a smooth function) on a uniform grid in dB
+ * and interpolates it linearly. The grid is refined at table construction
+ * until the relative error of -ln(s) is at most maxError at the midpoints of
+ * all cells. The chunk success rate then differs from the analytic one by at
+ * most maxError/e (about 0.37*maxError), regardless of the number of bits.
+ * The analytic model is still called outside the tabulated SNR range, in
+ * cells where s reaches 0 or 1 only at one end, and in cells that are not
+ * accurate enough even with the finest grid (discontinuities of the model).
+ *
+ * Tables are built on first use of a modulation and are shared among all
+ * instances that use the same kind of analytic model and the same maxError.
+ */
+class TableErrorRateModel : public IErrorModel
+{
+  protected:
+    struct Table
+    {
+        double minSnrDb;                // SNR of the first entry, in dB
+        double step;                    // distance of entries, in dB
+        std::vector<double> values;     // ln(-ln(s)), -inf where s==1, +inf where s==0, NaN where the analytic model must be used
+    };
+
+    /** the fields of ModulationType the analytic models depend on */
+    struct ModeKey
+    {
+        int modulationClass;
+        int constellationSize;
+        int codeRate;
+        uint32_t dataRate;
+        uint32_t phyRate;
+        uint32_t bandwidth;
+
+        ModeKey(const ModulationType& mode);
+        bool operator<(const ModeKey& other) const;
+    };
+
+    struct TableKey
+    {
+        std::string modelName;
+        double maxError;
+        ModeKey mode;
+
+        TableKey(const std::string& modelName, double maxError, const ModeKey& mode) : modelName(modelName), maxError(maxError), mode(mode) {}
+        bool operator<(const TableKey& other) const;
+    };
+
+    /** tables of all instances */
+    static std::map<TableKey, Table> tables;
+
+    IErrorModel *model;     // the analytic model, owned
+    std::string modelName;
+    double maxError;
+
+    /** the tables this instance used so far */
+    mutable std::map<ModeKey, const Table *> cache;
+
+  protected:
+    const Table *getTable(const ModulationType& mode) const;
+    void buildTable(const ModulationType& mode, Table& table) const;
+    double getExactValue(const ModulationType& mode, double snrDb) const;
+
+  private:
+    // not copyable
+    TableErrorRateModel(const TableErrorRateModel&);
+    TableErrorRateModel& operator=(const TableErrorRateModel&);
+
+  public:
+    /** Takes ownership of model. */
+    TableErrorRateModel(IErrorModel *model, double maxError);
+    virtual ~TableErrorRateModel();
+    virtual double GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const;
+};
+
+#endif /* TABLE_ERROR_RATE_MODEL_H */
@@ -111,11 +111,23 @@ void Ieee8021dRelay::broadcast(EtherFrame * frame)
 
     unsigned int arrivalGate = frame->getArrivalGate()->getIndex();
 
+    // copies share the encapsulated packet with the original (see cPacket::dup()),
+    // and the original itself goes out on the last port instead of being deleted
+    int pendingPort = -1;
     for (unsigned int i = 0; i < portCount; i++)
+    {
         if (i != arrivalGate && (!isStpAware || getPortInterfaceData(i)->isForwarding()))
-            dispatch(frame->dup(), i);
+        {
+            if (pendingPort != -1)
+                dispatch(frame->dup(), pendingPort);
+            pendingPort = i;
+        }
+    }
 
-    delete frame;
+    if (pendingPort != -1)
+        dispatch(frame, pendingPort);
+    else
+        delete frame;
 }
 
 void Ieee8021dRelay::handleAndDispatchFrame(EtherFrame * frame)
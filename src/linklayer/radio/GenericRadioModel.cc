@@ -60,14 +60,8 @@ double GenericRadioModel::calculateDuration(AirFrame *airframe)
 }
 
 
-PhyIndication GenericRadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList& receivedList)
+PhyIndication GenericRadioModel::isReceivedCorrectly(AirFrame *airframe, double snirMin)
 {
-    // calculate snirMin
-    double snirMin = receivedList.begin()->snr;
-    for (SnrList::const_iterator iter = receivedList.begin(); iter != receivedList.end(); iter++)
-        if (iter->snr < snirMin)
-            snirMin = iter->snr;
-
     if (snirMin <= snirThreshold)
     {
         // if snir is too low for the packet to be recognized
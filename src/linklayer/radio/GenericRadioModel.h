@@ -44,7 +44,7 @@ class INET_API GenericRadioModel : public IRadioModel
 
     virtual double calculateDuration(AirFrame *airframe);
 
-    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, const SnrList& receivedList);
+    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, double snirMin);
 
     // used by the Airtime Link Metric computation
     virtual bool haveTestFrame() {return false;}
@@ -20,7 +20,6 @@
 
 #include "INETDefs.h"
 #include "AirFrame_m.h"
-#include "SnrList.h"
 #include "PhyControlInfo_m.h"
 
 /**
@@ -53,11 +52,11 @@ class INET_API IRadioModel : public cObject
 
     /**
      * Should be defined to calculate whether the frame has been received
-     * correctly. Input is the signal-noise ratio over the duration of the
-     * frame. The calculation may take into account the modulation scheme,
-     * possible error correction code, etc.
+     * correctly. Input is the minimum of the signal-noise ratio over the
+     * duration of the frame. The calculation may take into account the
+     * modulation scheme, possible error correction code, etc.
      */
-    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, const SnrList& receivedList) = 0;
+    virtual PhyIndication isReceivedCorrectly(AirFrame *airframe, double snirMin) = 0;
     // used by the Airtime Link Metric computation
     virtual bool haveTestFrame()=0;
     virtual double calculateDurationTestFrame(AirFrame *airframe)=0;
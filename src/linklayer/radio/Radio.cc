@@ -20,6 +20,8 @@
 //
 
 
+#include <float.h>
+
 #include "Radio.h"
 #include "FWMath.h"
 #include "PhyControlInfo_m.h"
@@ -30,7 +32,6 @@
 
 
 #define MK_TRANSMISSION_OVER  1
-#define MK_RECEPTION_COMPLETE 2
 
 simsignal_t Radio::bitrateSignal = registerSignal("bitrate");
 simsignal_t Radio::radioStateSignal = registerSignal("radioState");
@@ -96,6 +97,7 @@ void Radio::initialize(int stage)
         // initialize the pointer of the snrInfo with NULL to indicate
         // that currently no message is received
         snrInfo.ptr = NULL;
+        recvBuff.reserve(16);
 
         // no channel switch pending
         newChannel = -1;
@@ -181,6 +183,9 @@ void Radio::initialize(int stage)
     }
     else if (stage == 2)
     {
+        // for the optional reception filter of ChannelControl
+        cc->setRadioReceptionModel(myRadioRef, receptionModel, thermalNoise);
+
         NodeStatus *nodeStatus = dynamic_cast<NodeStatus *>(findContainingNode(this)->getSubmodule("status"));
         bool isOperational = (!nodeStatus) || nodeStatus->getState() == NodeStatus::UP;
         if (isOperational)
@@ -221,9 +226,9 @@ Radio::~Radio()
 
     if (updateString)
         cancelAndDelete(updateString);
-    // delete messages being received
+    // delete messages being received (they are scheduled as end-of-reception events)
     for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-        delete it->first;
+        cancelAndDelete(it->airframe);
 }
 
 bool Radio::handleOperationStage(LifecycleOperation *operation, int stage, IDoneCallback *doneCallback)
@@ -327,21 +332,17 @@ void Radio::handleMessage(cMessage *msg)
 
 /**
  * The packet is put in a buffer for the time the transmission would
- * last in reality. A timer indicates when the transmission is
- * complete. So, look at unbufferMsg to see what happens when the
- * transmission is complete..
+ * last in reality. The frame itself is scheduled as a self message
+ * to indicate when the transmission is complete, so no separate timer
+ * has to be allocated per reception. So, look at unbufferMsg to see
+ * what happens when the transmission is complete..
  */
 void Radio::bufferMsg(AirFrame *airframe) //FIXME: add explicit simtime_t atTime arg?
 {
-    // set timer to indicate transmission is complete
-    cMessage *endRxTimer = new cMessage("endRx", MK_RECEPTION_COMPLETE);
-    endRxTimer->setContextPointer(airframe);
-    airframe->setContextPointer(endRxTimer);
-
     // NOTE: use arrivalTime instead of simTime, because we might be calling this
     // function during a channel change, when we're picking up ongoing transmissions
     // on the channel -- and then the message's arrival time is in the past!
-    scheduleAt(airframe->getArrivalTime() + airframe->getDuration(), endRxTimer);
+    scheduleAt(airframe->getArrivalTime() + airframe->getDuration(), airframe);
 }
 
 AirFrame *Radio::encapsulatePacket(cPacket *frame)
@@ -399,16 +400,12 @@ void Radio::sendDown(AirFrame *airframe)
 }
 
 /**
- * Get the context pointer to the now completely received AirFrame and
- * delete the self message
+ * Returns the now completely received AirFrame, which was scheduled
+ * as the end-of-reception self message
  */
 AirFrame *Radio::unbufferMsg(cMessage *msg)
 {
-    AirFrame *airframe = (AirFrame *) msg->getContextPointer();
-    //delete the self message
-    delete msg;
-
-    return airframe;
+    return check_and_cast<AirFrame *>(msg);
 }
 
 /**
@@ -438,8 +435,6 @@ void Radio::handleUpperMsg(AirFrame *airframe)
 
         // delete the pointer to indicate that no message is being received
         snrInfo.ptr = NULL;
-        // clear the snr list
-        snrInfo.sList.clear();
         // add the receive power to the noise level
         noiseLevel += snrInfo.rcvdPower;
     }
@@ -516,7 +511,7 @@ void Radio::handleCommand(int msgkind, cObject *ctrl)
 void Radio::handleSelfMsg(cMessage *msg)
 {
     EV<<"Radio::handleSelfMsg"<<msg->getKind()<<endl;
-    if (msg->getKind()==MK_RECEPTION_COMPLETE)
+    if (dynamic_cast<AirFrame *>(msg))
     {
         EV << "frame is completely received now\n";
 
@@ -594,7 +589,7 @@ void Radio::handleSelfMsg(cMessage *msg)
  * -# the host is currently not sending a message
  * -# no other packet is already being received
  *
- * If all conditions apply a new SnrList is created and the RadioState
+ * If all conditions apply the SNR info is reset and the RadioState
  * is changed to RECV.
  *
  * If the packet is just noise the receive power is added to the noise
@@ -623,7 +618,10 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         rcvdPower = obstacles->calculateReceivedPower(rcvdPower, carrierFrequency, framePos, 0, getRadioPosition(), 0);
     airframe->setPowRec(rcvdPower);
     // store the receive power in the recvBuff
-    recvBuff[airframe] = rcvdPower;
+    Reception reception;
+    reception.airframe = airframe;
+    reception.rcvdPower = rcvdPower;
+    recvBuff.push_back(reception);
     updateSensitivity(airframe->getBitrate());
 
     // if receive power is bigger than sensitivity and if not sending
@@ -635,11 +633,10 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
     {
         EV << "receiving frame " << airframe->getName() << endl;
 
-        // Put frame and related SnrList in receive buffer
-        SnrList snrList;
+        // Put frame and related SNR info in receive buffer
         snrInfo.ptr = airframe;
         snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
+        snrInfo.snirMin = DBL_MAX;
 
         // add initial snr value
         addNewSnr();
@@ -685,7 +682,7 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
  * Additionally the RadioState has to be updated.
  *
  * If the corresponding AirFrame was not only noise the corresponding
- * SnrList and the AirFrame are sent to the decider.
+ * minimum SNR and the AirFrame are sent to the decider.
  */
 void Radio::handleLowerMsgEnd(AirFrame * airframe)
 {
@@ -693,30 +690,22 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     if (snrInfo.ptr == airframe)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
 
         // delete the pointer to indicate that no message is currently
-        // being received and clear the list
-
-        double snirMin = snrInfo.sList.begin()->snr;
-        for (SnrList::const_iterator iter = snrInfo.sList.begin(); iter != snrInfo.sList.end(); iter++)
-            if (iter->snr < snirMin)
-                snirMin = iter->snr;
+        // being received
+        double snirMin = snrInfo.snirMin;
         snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
         airframe->setSnr(10*log10(snirMin)); //ahmed
         airframe->setLossRate(lossRate);
         // delete the frame from the recvBuff
-        recvBuff.erase(airframe);
+        removeFromRecvBuff(airframe);
 
         //XXX send up the frame:
-        //if (radioModel->isReceivedCorrectly(airframe, list))
+        //if (radioModel->isReceivedCorrectly(airframe, snirMin))
         //    sendUp(airframe);
         //else
         //    delete airframe;
-        PhyIndication frameState = radioModel->isReceivedCorrectly(airframe, list);
+        PhyIndication frameState = radioModel->isReceivedCorrectly(airframe, snirMin);
         if (frameState != FRAMEOK)
         {
             airframe->getEncapsulatedPacket()->setKind(frameState);
@@ -740,11 +729,9 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     else
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
-        // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[airframe];
-
-        // delete message from the recvBuff
-        recvBuff.erase(airframe);
+        // get the rcvdPower and subtract it from the noiseLevel,
+        // and delete message from the recvBuff
+        noiseLevel -= removeFromRecvBuff(airframe);
 
         // update snr info for message currently being received if any
         if (snrInfo.ptr != NULL)
@@ -771,10 +758,31 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
 
 void Radio::addNewSnr()
 {
-    SnrListEntry listEntry;     // create a new entry
-    listEntry.time = simTime();
-    listEntry.snr = snrInfo.rcvdPower / (BASE_NOISE_LEVEL);
-    snrInfo.sList.push_back(listEntry);
+    double snr = snrInfo.rcvdPower / (BASE_NOISE_LEVEL);
+    if (snr < snrInfo.snirMin)
+        snrInfo.snirMin = snr;
+}
+
+double Radio::removeFromRecvBuff(AirFrame *airframe)
+{
+    for (RecvBuff::iterator it = recvBuff.begin(); it != recvBuff.end(); ++it)
+    {
+        if (it->airframe == airframe)
+        {
+            double rcvdPower = it->rcvdPower;
+            *it = recvBuff.back();
+            recvBuff.pop_back();
+            return rcvdPower;
+        }
+    }
+    return 0;
+}
+
+void Radio::clearRecvBuff()
+{
+    for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
+        delete cancelEvent(it->airframe);
+    recvBuff.clear();
 }
 
 void Radio::changeChannel(int channel)
@@ -784,19 +792,11 @@ void Radio::changeChannel(int channel)
     if (rs.getState() == RadioState::TRANSMIT)
         error("changing channel while transmitting is not allowed");
 
-   // Clear the recvBuff
-   for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-   {
-        AirFrame *airframe = it->first;
-        cMessage *endRxTimer = (cMessage *)airframe->getContextPointer();
-        delete airframe;
-        delete cancelEvent(endRxTimer);
-    }
-    recvBuff.clear();
+    // Clear the recvBuff
+    clearRecvBuff();
 
     // clear snr info
     snrInfo.ptr = NULL;
-    snrInfo.sList.clear();
 
     // reset the noiseLevel
     noiseLevel = thermalNoise;
@@ -822,7 +822,7 @@ void Radio::changeChannel(int channel)
 
     // pick up ongoing transmissions on the new channel
     EV << "Picking up ongoing transmissions on new channel:\n";
-    IChannelControl::TransmissionList tlAux = cc->getOngoingTransmissions(channel);
+    IChannelControl::TransmissionList tlAux = cc->getOngoingTransmissions(myRadioRef, channel);
     for (IChannelControl::TransmissionList::const_iterator it = tlAux.begin(); it != tlAux.end(); ++it)
     {
         AirFrame *airframe = check_and_cast<AirFrame *> (*it);
@@ -1069,19 +1069,11 @@ void Radio::disconnectReceiver()
     if (rs.getState() == RadioState::TRANSMIT)
         error("changing channel while transmitting is not allowed");
 
-   // Clear the recvBuff
-   for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-   {
-        AirFrame *airframe = it->first;
-        cMessage *endRxTimer = (cMessage *)airframe->getContextPointer();
-        delete airframe;
-        delete cancelEvent(endRxTimer);
-    }
-    recvBuff.clear();
+    // Clear the recvBuff
+    clearRecvBuff();
 
     // clear snr info
     snrInfo.ptr = NULL;
-    snrInfo.sList.clear();
 }
 
 void Radio::connectReceiver()
@@ -1103,7 +1095,7 @@ void Radio::connectReceiver()
 
     // pick up ongoing transmissions on the new channel
     EV << "Picking up ongoing transmissions on new channel:\n";
-    IChannelControl::TransmissionList tlAux = cc->getOngoingTransmissions(rs.getChannelNumber());
+    IChannelControl::TransmissionList tlAux = cc->getOngoingTransmissions(myRadioRef, rs.getChannelNumber());
     for (IChannelControl::TransmissionList::const_iterator it = tlAux.begin(); it != tlAux.end(); ++it)
     {
         AirFrame *airframe = check_and_cast<AirFrame *> (*it);
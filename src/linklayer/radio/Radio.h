@@ -24,7 +24,6 @@
 #include "AirFrame_m.h"
 #include "IRadioModel.h"
 #include "IReceptionModel.h"
-#include "SnrList.h"
 #include "ObstacleControl.h"
 #include "INoiseGenerator.h"
 #include "ILifecycle.h"
@@ -108,6 +107,12 @@ class INET_API Radio : public ChannelAccess, public ILifecycle
     /** Updates the SNR information of the relevant AirFrame */
     virtual void addNewSnr();
 
+    /** Removes the frame from recvBuff, and returns its receive power (0 if it was not there) */
+    virtual double removeFromRecvBuff(AirFrame *airframe);
+
+    /** Deletes all frames being received, together with their end-of-reception timers */
+    virtual void clearRecvBuff();
+
     /** Create a new AirFrame */
     virtual AirFrame *createAirFrame() {return new AirFrame();}
 
@@ -177,38 +182,39 @@ class INET_API Radio : public ChannelAccess, public ILifecycle
     //@}
 
     /**
-     * Struct to store a pointer to the message, rcvdPower AND a SnrList,
-     * needed in addNewSnr().
+     * Struct to store a pointer to the message, rcvdPower AND the minimum
+     * SNR so far, needed in addNewSnr().
      */
     struct SnrStruct
     {
         AirFrame *ptr;    ///< pointer to the message this information belongs to
         double rcvdPower; ///< received power of the message
-        SnrList sList;    ///< stores SNR over time
+        double snirMin;   ///< minimum SNR since the start of the reception
     };
 
     /**
-     * State: SnrInfo stores the snrList and the the recvdPower for the
+     * State: SnrInfo stores the minimum SNR and the the recvdPower for the
      * message currently being received, together with a pointer to the
      * message.
      */
     SnrStruct snrInfo;
 
     /**
-     * Typedef used to store received messages together with
+     * Struct used to store received messages together with
      * receive power.
      */
-    struct Compare {
-        bool operator() (AirFrame* const &lhs, AirFrame* const &rhs) const {
-            ASSERT(lhs && rhs);
-            return lhs->getId() < rhs->getId();
-        }
+    struct Reception
+    {
+        AirFrame *airframe;
+        double rcvdPower;
     };
-    typedef std::map<AirFrame*, double, Compare> RecvBuff;
+    typedef std::vector<Reception> RecvBuff;
 
     /**
      * State: A buffer to store a pointer to a message and the related
-     * receive power.
+     * receive power. Only a few frames overlap at any time, so it is
+     * a flat vector searched linearly; it does not allocate once it has
+     * grown to the maximum number of overlapping frames.
      */
     RecvBuff recvBuff;
 
@@ -52,13 +52,27 @@ void FreeSpaceModel::initializeFrom(cModule *radioModule)
 
 double FreeSpaceModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
-    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
-    double prec = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
-    if (prec > pSend)
-        prec = pSend;
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
     return prec;
 }
 
+void FreeSpaceModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
+    freeSpace(Gt, Gr, L, pSend, waveLength, distances, powers, n, pathLossAlpha);
+    for (int i = 0; i < n; i++)
+        if (powers[i] > pSend)
+            powers[i] = pSend;
+}
+
+bool FreeSpaceModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // deterministic
+    FreeSpaceModel::calculateReceivedPowers(pSend, carrierFrequency, distances, powers, n);
+    return true;
+}
+
 /** @brief calculates the power with the deterministic free space propagation model */
 double FreeSpaceModel::freeSpace(double Gt, double Gr, double L, double Pt, double lambda, double distance, double alpha)
 {
@@ -81,6 +95,15 @@ double FreeSpaceModel::freeSpace(double Gt, double Gr, double L, double Pt, doub
   return pr;
 }
 
+/** @brief same as the scalar version, with the distance independent terms computed once */
+void FreeSpaceModel::freeSpace(double Gt, double Gr, double L, double Pt, double lambda, const double *distances, double *powers, int n, double alpha)
+{
+  double numerator = Pt * lambda * lambda * Gt * Gr;
+  double factor = 16.0 *M_PI * M_PI;
+  for (int i = 0; i < n; i++)
+    powers[i] = distances[i] == 0.0 ? Pt : numerator / (factor * pow(distances[i], alpha) * L);
+}
+
 double FreeSpaceModel::calculateDistance(double pSend, double pRec, double carrierFrequency)
 {
   /** @brief
@@ -40,6 +40,30 @@ class INET_API IReceptionModel : public cObject
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance) = 0;
 
+    /**
+     * Calculates the received power of the same transmission at n distances
+     * (powers[i] belongs to distances[i]). The default implementation calls
+     * calculateReceivedPower() for each distance; models redefine it to compute
+     * the distance independent terms only once, in loops the compiler can vectorize.
+     * Random numbers must be drawn in the same order as n separate calls would do.
+     */
+    virtual void calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+    {
+        for (int i = 0; i < n; i++)
+            powers[i] = calculateReceivedPower(pSend, carrierFrequency, distances[i]);
+    }
+
+    /**
+     * Stores an upper bound of the power calculateReceivedPowers() may return
+     * at each distance, and returns true. Must not draw random numbers. Models
+     * without such a bound (e.g. fading with an unbounded gain) return false;
+     * this is the default.
+     */
+    virtual bool calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+    {
+        return false;
+    }
+
     /**
      * Virtual destructor.
      */
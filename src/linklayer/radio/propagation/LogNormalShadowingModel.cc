@@ -34,6 +34,13 @@ void LogNormalShadowingModel::initializeFrom(cModule *radioModule)
 
 
 double LogNormalShadowingModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
+
+void LogNormalShadowingModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
 {
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double d0 = 1.0;
@@ -42,20 +49,32 @@ double LogNormalShadowingModel::calculateReceivedPower(double pSend, double carr
 
     double PL_d0 = freeSpace(Gt, Gr, L, pSend, waveLength, d0, pathLossAlpha);
     double PL_d0_db = 10.0 * log10(pSend / PL_d0);
+    double pSend_db = 10.0 * log10(pSend);
 
-    // Pathloss at distance d + normal distribution
-    // normal-distr. assumes std-deviation: s
-    double PL_db = PL_d0_db + 10 * pathLossAlpha * log10(distance/d0) + normal(0.0, sigma);
+    // deterministic part of the pathloss at distance d
+    for (int i = 0; i < n; i++)
+        powers[i] = PL_d0_db + 10 * pathLossAlpha * log10(distances[i]/d0);
 
-    // Reception power = Tx Power - Pathloss
-    double Prx_db = (10.0 * log10(pSend)) - PL_db;
+    for (int i = 0; i < n; i++)
+    {
+        // Pathloss at distance d + normal distribution
+        // normal-distr. assumes std-deviation: s
+        double PL_db = powers[i] + normal(0.0, sigma);
 
-    //EV << "dist " << distance << " avg_power " << f2db(avg->power(distance, Pt)) << " lns_power " << Prx_db << endl;
+        // Reception power = Tx Power - Pathloss
+        double Prx_db = pSend_db - PL_db;
 
-    // convert dBm to mW
-    double prec = pow(10, Prx_db/10.0);
-    if (prec > pSend)
-        prec = pSend;
-    return prec;
+        // convert dBm to mW
+        double prec = pow(10, Prx_db/10.0);
+        if (prec > pSend)
+            prec = pSend;
+        powers[i] = prec;
+    }
+}
+
+bool LogNormalShadowingModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // the shadowing term has no upper bound
+    return false;
 }
 
@@ -34,14 +34,30 @@ void NakagamiModel::initializeFrom(cModule *radioModule)
 
 
 double NakagamiModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
+
+void NakagamiModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
 {
     const int rng = 0;
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
 
-    double avg_power = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
-    avg_power = avg_power/1000;
-    double prec = gamma_d(m, avg_power / m, rng) * 1000.0;
-     if (prec > pSend)
-        prec = pSend;
-     return prec;
+    freeSpace(Gt, Gr, L, pSend, waveLength, distances, powers, n, pathLossAlpha);
+    for (int i = 0; i < n; i++)
+    {
+        double avg_power = powers[i]/1000;
+        double prec = gamma_d(m, avg_power / m, rng) * 1000.0;
+        if (prec > pSend)
+            prec = pSend;
+        powers[i] = prec;
+    }
+}
+
+bool NakagamiModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // the fading gain has no upper bound
+    return false;
 }
@@ -36,6 +36,8 @@ class INET_API NakagamiModel : public FreeSpaceModel {
      * To be redefined to calculate the received power of a transmission.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
+    virtual void calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n);
+    virtual bool calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n);
 
     protected:
     double m;
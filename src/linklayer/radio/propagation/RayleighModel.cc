@@ -38,16 +38,31 @@ RayleighModel::~RayleighModel() {
 
 
 double RayleighModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
+
+void RayleighModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
 {
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
-    double avg_rx_power = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
+    freeSpace(Gt, Gr, L, pSend, waveLength, distances, powers, n, pathLossAlpha);
 
-    double x = normal(0, 1);
-    double y = normal(0, 1);
-    double prec = avg_rx_power * 0.5 * (x*x + y*y);
-    if (prec > pSend)
-        prec = pSend;
-    return prec;
+    for (int i = 0; i < n; i++)
+    {
+        double x = normal(0, 1);
+        double y = normal(0, 1);
+        double prec = powers[i] * 0.5 * (x*x + y*y);
+        if (prec > pSend)
+            prec = pSend;
+        powers[i] = prec;
+    }
+}
 
+bool RayleighModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // the fading gain has no upper bound
+    return false;
 }
 
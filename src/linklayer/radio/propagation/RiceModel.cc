@@ -35,18 +35,35 @@ void RiceModel::initializeFrom(cModule *radioModule)
 }
 
 double RiceModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
+
+void RiceModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
 {
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double c = 1.0/(2.0*(K+1));
-    double x = normal(0, 1);
-    double y = normal(0, 1);
-    double rr = c*( (x + sqrt(2*K))*(x + sqrt(2*K)) + y*y);
-    double prec = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha) * rr;
-    if (prec > pSend)
-        prec = pSend;
-    return prec;
+    double sqrt2K = sqrt(2*K);
+    freeSpace(Gt, Gr, L, pSend, waveLength, distances, powers, n, pathLossAlpha);
 
+    for (int i = 0; i < n; i++)
+    {
+        double x = normal(0, 1);
+        double y = normal(0, 1);
+        double rr = c*( (x + sqrt2K)*(x + sqrt2K) + y*y);
+        double prec = powers[i] * rr;
+        if (prec > pSend)
+            prec = pSend;
+        powers[i] = prec;
+    }
+}
 
+bool RiceModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // the fading gain has no upper bound
+    return false;
 }
 
 
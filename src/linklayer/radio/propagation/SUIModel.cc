@@ -36,58 +36,65 @@ void SUIModel::initializeFrom(cModule *radioModule)
     Gt = pow(10, radioModule->par("TransmissionAntennaGainIndB").doubleValue()/10);
     Gr = pow(10, radioModule->par("ReceiveAntennaGainIndB").doubleValue()/10);
 
-}
-
-double SUIModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
-{
     /*
      * Terrain A - Highest path loss. Dense populated urban area.
      * Terrain B - Intermediate path loss. Suburban area.
      * Terrain C - Minimum path loss. Flat areas or rural with light vegetation.
      */
-
-    double a,b,c,d,s;
     if (terrain=="TerrainA") { a=4.6;   b=0.0075;   c=12.6; d=10.8; s=10.6; }
-    if (terrain=="TerrainB") { a=4.0;   b=0.0065;   c=17.1; d=10.8; s=9.6;  }
-    if (terrain=="TerrainC") { a=3.6;   b=0.0050;   c=20.0; d=20.0; s=8.2;  }
+    else if (terrain=="TerrainB") { a=4.0;   b=0.0065;   c=17.1; d=10.8; s=9.6;  }
+    else if (terrain=="TerrainC") { a=3.6;   b=0.0050;   c=20.0; d=20.0; s=8.2;  }
+    else opp_error("SUIModel: unknown terrain '%s'", terrain.c_str());
+}
 
-    double R = distance;    // [m]
+double SUIModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
+
+void SUIModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
     double R0 = 100.0;      // [m]
     double lambda = SPEED_OF_LIGHT / carrierFrequency;
-    double Pr = 0.0;        // [dBm]
     double Pt = 10*log10(pSend/1);  // [dBm]
-    double prec = 0.0;     // [mW]
-    double L = 0.0;        // [dBm]
     double f = carrierFrequency / 1000000000.0; // [GHz]
 
-    double alpha = 0.0;
     double gamma = a - b*ht + c/ht;
     double Xf = 6 * log10( f/2 );
     double Xh = -d * log10( hr/2 );
 
     double R0p = R0 * pow(10.0,-( (Xf+Xh) / (10*gamma) ));
+    double alpha = 20 * log10( (4*M_PI*R0p) / lambda );
 
-
-    if(R>R0p)
-    {
-        alpha = 20 * log10( (4*M_PI*R0p) / lambda );
-        L = alpha + 10*gamma*log10( R/R0 ) + Xf + Xh + s;
-    }
-    else
+    for (int i = 0; i < n; i++)
     {
-        L = 20 * log10( (4*M_PI*R) / lambda ) + s;
-    }
-
-    Pr = Pt + Gt + Gr - L;
+        double R = distances[i];    // [m]
+        double L = 0.0;        // [dBm]
 
-    prec = pow(10, Pr/10.0); // [dBm]->[mW]
+        if(R>R0p)
+        {
+            L = alpha + 10*gamma*log10( R/R0 ) + Xf + Xh + s;
+        }
+        else
+        {
+            L = 20 * log10( (4*M_PI*R) / lambda ) + s;
+        }
 
+        double Pr = Pt + Gt + Gr - L;   // [dBm]
 
-    if (prec > pSend)
-        prec = pSend;
-    return prec;
+        double prec = pow(10, Pr/10.0); // [dBm]->[mW]
 
+        if (prec > pSend)
+            prec = pSend;
+        powers[i] = prec;
+    }
 }
 
-
-
+bool SUIModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // deterministic
+    SUIModel::calculateReceivedPowers(pSend, carrierFrequency, distances, powers, n);
+    return true;
+}
@@ -50,6 +50,8 @@ public:
      * To be redefined to calculate the received power of a transmission.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
+    virtual void calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n);
+    virtual bool calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n);
 private:
     /** @brief  Terrain type */
     string terrain;
@@ -66,6 +68,9 @@ private:
     /** @brief  Transmitter Antenna Gain */
     double Gt;
 
+    /** @brief  Terrain dependent model parameters */
+    double a, b, c, d, s;
+
 };
 
 
@@ -39,10 +39,14 @@ TwoRayGroundModel::~TwoRayGroundModel()
 
 double TwoRayGroundModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
-    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
+    double prec;
+    calculateReceivedPowers(pSend, carrierFrequency, &distance, &prec, 1);
+    return prec;
+}
 
-    if (distance == 0)
-        return pSend;
+void TwoRayGroundModel::calculateReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
 
     /**
      * cross over distance dc
@@ -55,32 +59,44 @@ double TwoRayGroundModel::calculateReceivedPower(double pSend, double carrierFre
 
     double dc = (4 * M_PI * ht * hr ) / waveLength;
 
-    if (distance < dc )
-    {
-        /**
-         * Friis free space equation:
-         *
-         *       Pt * Gt * Gr * (lambda^2)
-         *   P = --------------------------
-         *       (4 * pi)^2 * d^2 * L
-         */
-        return freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
-    }
-    else
+    /**
+     * Friis free space equation, used below dc:
+     *
+     *       Pt * Gt * Gr * (lambda^2)
+     *   P = --------------------------
+     *       (4 * pi)^2 * d^2 * L
+     */
+    freeSpace(Gt, Gr, L, pSend, waveLength, distances, powers, n, pathLossAlpha);
+
+    /**
+     *  Two-ray ground reflection model, used from dc on.
+     *
+     *       Pt * gt * gr * (ht^2 * hr^2)
+     *  Pr = ----------------------------
+     *                 d^4 * L
+     *
+     * To be consistant with the free space equation, L is added here.
+     * The original equation in Rappaport's book assumes L = 1.
+     */
+    double numerator = (pSend * Gt * Gr * (ht * ht * hr * hr) );
+    for (int i = 0; i < n; i++)
     {
-        /**
-         *  Two-ray ground reflection model.
-         *
-         *       Pt * gt * gr * (ht^2 * hr^2)
-         *  Pr = ----------------------------
-         *                 d^4 * L
-         *
-         * To be consistant with the free space equation, L is added here.
-         * The original equation in Rappaport's book assumes L = 1.
-         */
-        double prec = ((pSend * Gt * Gr * (ht * ht * hr * hr) ) / (distance * distance * distance * distance * L));
-        if (prec > pSend)
-            prec = pSend;
-        return prec;
+        double distance = distances[i];
+        if (distance == 0)
+            powers[i] = pSend;
+        else if (distance >= dc)
+        {
+            double prec = numerator / (distance * distance * distance * distance * L);
+            if (prec > pSend)
+                prec = pSend;
+            powers[i] = prec;
+        }
     }
 }
+
+bool TwoRayGroundModel::calculateMaxReceivedPowers(double pSend, double carrierFrequency, const double *distances, double *powers, int n)
+{
+    // deterministic
+    TwoRayGroundModel::calculateReceivedPowers(pSend, carrierFrequency, distances, powers, n);
+    return true;
+}
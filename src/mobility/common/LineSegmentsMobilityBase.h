@@ -55,6 +55,9 @@ class INET_API LineSegmentsMobilityBase : public MovingMobilityBase
 
   public:
     LineSegmentsMobilityBase();
+
+    /** @brief Returns the speed of the current linear movement; it only changes when the next one starts. */
+    virtual double getMaxSpeed() { return lastSpeed.length(); }
 };
 
 #endif
@@ -76,6 +76,12 @@ class INET_API MobilityBase : public cSimpleModule, public IMobility
   protected:
     MobilityBase();
 
+  public:
+    /** @brief Returns -1, i.e. the speed is not known in advance; subclasses may redefine. */
+    virtual double getMaxSpeed() { return -1; }
+
+  protected:
+
     /** @brief Returns the required number of initialize stages. */
     virtual int numInitStages() const { return 3; }
 
@@ -93,12 +93,16 @@ void MovingMobilityBase::scheduleUpdate()
 
 Coord MovingMobilityBase::getCurrentPosition()
 {
+    // may be called from other modules, e.g. ChannelControl when it tracks positions lazily;
+    // moving may draw random numbers, which must come from this module's RNGs
+    Enter_Method_Silent();
     moveAndUpdate();
     return lastPosition;
 }
 
 Coord MovingMobilityBase::getCurrentSpeed()
 {
+    Enter_Method_Silent();
     moveAndUpdate();
     return lastSpeed;
 }
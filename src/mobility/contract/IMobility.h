@@ -49,6 +49,13 @@ class INET_API IMobility
     /** @brief Returns the current speed at the current simulation time. */
     virtual Coord getCurrentSpeed() = 0;
 
+    /** @brief Returns an upper bound of the speed (in m/s) until the next mobility state change signal, or -1 if not known.
+     *
+     * A non-negative value also promises that getCurrentPosition() computes the position
+     * for any simulation time, so the module does not need to be updated periodically.
+     * The default -1 means unbounded; such radios are not tracked lazily by ChannelControl. */
+    virtual double getMaxSpeed() { return -1; }
+
     /** @brief Returns the current acceleration at the current simulation time. */
     // virtual Coord getCurrentAcceleration() = 0;
 
@@ -93,6 +93,9 @@ class INET_API MoBANLocal : public LineSegmentsMobilityBase
 
     virtual Coord getCurrentSpeed();
 
+    /** @brief Returns -1, the reference point is moved by the coordinator. */
+    virtual double getMaxSpeed() { return -1; }
+
     void setCoordinator(MoBANCoordinator *coordinator) { this->coordinator = coordinator; }
 
     void setMoBANParameters(Coord referencePoint, double radius, double speed);
@@ -59,6 +59,8 @@ class INET_API CircleMobility : public MovingMobilityBase
 
   public:
     CircleMobility();
+
+    virtual double getMaxSpeed() { return fabs(speed); }
 };
 
 #endif
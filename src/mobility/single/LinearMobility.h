@@ -49,6 +49,9 @@ class INET_API LinearMobility : public MovingMobilityBase
 
   public:
     LinearMobility();
+
+    /** @brief Returns the speed, or -1 if the host accelerates (the movement is then integrated step by step). */
+    virtual double getMaxSpeed() { return acceleration == 0 ? fabs(speed) : -1; }
 };
 
 #endif
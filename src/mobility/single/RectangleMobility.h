@@ -57,6 +57,8 @@ class INET_API RectangleMobility : public MovingMobilityBase
 
   public:
     RectangleMobility();
+
+    virtual double getMaxSpeed() { return fabs(speed); }
 };
 
 #endif
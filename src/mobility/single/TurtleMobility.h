@@ -75,6 +75,9 @@ class INET_API TurtleMobility : public LineSegmentsMobilityBase
 
   public:
     TurtleMobility();
+
+    /** @brief Returns -1 if the border policy can make the host jump. */
+    virtual double getMaxSpeed() { return borderPolicy == REFLECT || borderPolicy == RAISEERROR ? LineSegmentsMobilityBase::getMaxSpeed() : -1; }
 };
 
 #endif
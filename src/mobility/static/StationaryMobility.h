@@ -42,6 +42,9 @@ class INET_API StationaryMobility : public MobilityBase
 
     /** @brief Returns the current speed at the current simulation time. */
     virtual Coord getCurrentSpeed() { return Coord::ZERO; }
+
+    /** @brief Returns 0, the host never moves. */
+    virtual double getMaxSpeed() { return 0; }
 };
 
 #endif
@@ -19,25 +19,41 @@
 //
 
 #include <set>
+#include <platdep/timeutil.h>
 #include "stlutils.h"
 #include "IRoutingTable.h"
 #include "IInterfaceTable.h"
 #include "IPv4NetworkConfigurator.h"
 #include "InterfaceEntry.h"
 #include "ModuleAccess.h"
+#include "IPv4RouteAggregator.h"
+#include "ParallelLoop.h"
 #include "XMLUtils.h"
 
 Define_Module(IPv4NetworkConfigurator);
 
 #define ADDRLEN_BITS 32
-#define T(CODE)  {long startTime=clock(); CODE; printElapsedTime(#CODE, startTime);}
+#define T(CODE)  {double startTime=getWallClockTime(); CODE; printElapsedTime(#CODE, startTime);}
 
 inline bool isEmpty(const char *s) {return !s || !s[0];}
 inline bool isNotEmpty(const char *s) {return s && s[0];}
 
-static void printElapsedTime(const char *name, long startTime)
+// wall clock time, so that the timings show the effect of running things in parallel
+static double getWallClockTime()
 {
-    EV_INFO << "Time spent in IPv4NetworkConfigurator::" << name << ": " << ((double)(clock() - startTime) / CLOCKS_PER_SEC) << "s" << endl;
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1E6;
+}
+
+static void printSpentTime(const char *name, double time)
+{
+    EV_INFO << "Time spent in IPv4NetworkConfigurator::" << name << ": " << time << "s" << endl;
+}
+
+static void printElapsedTime(const char *name, double startTime)
+{
+    printSpentTime(name, getWallClockTime() - startTime);
 }
 
 IPv4NetworkConfigurator::InterfaceInfo::InterfaceInfo(Node *node, LinkInfo *linkInfo, InterfaceEntry *interfaceEntry)
@@ -57,24 +73,6 @@ IPv4NetworkConfigurator::InterfaceInfo::InterfaceInfo(Node *node, LinkInfo *link
     netmaskSpecifiedBits = 0;
 }
 
-int IPv4NetworkConfigurator::RoutingTableInfo::addRouteInfo(RouteInfo *routeInfo)
-{
-    std::vector<RouteInfo *>::iterator it = upper_bound(routeInfos.begin(), routeInfos.end(), routeInfo, routeInfoLessThan);
-    int index = it - routeInfos.begin();
-    routeInfos.insert(it, routeInfo);
-    return index;
-}
-
-IPv4NetworkConfigurator::RouteInfo *IPv4NetworkConfigurator::RoutingTableInfo::findBestMatchingRouteInfo(const uint32 destination, int begin, int end) const
-{
-    for (int index = begin; index < end; index++) {
-        RouteInfo *routeInfo = routeInfos.at(index);
-        if (routeInfo->enabled && !((destination ^ routeInfo->destination) & routeInfo->netmask))
-            return const_cast<RouteInfo *>(routeInfo);
-    }
-    return NULL;
-}
-
 void IPv4NetworkConfigurator::initialize(int stage)
 {
     cSimpleModule::initialize(stage);
@@ -87,6 +85,7 @@ void IPv4NetworkConfigurator::initialize(int stage)
         addSubnetRoutesParameter = par("addSubnetRoutes");
         addDefaultRoutesParameter = par("addDefaultRoutes");
         optimizeRoutesParameter = par("optimizeRoutes");
+        numThreadsParameter = par("numThreads");
         configuration = par("config");
     }
     else if (stage == 2)
@@ -97,7 +96,7 @@ void IPv4NetworkConfigurator::initialize(int stage)
 
 void IPv4NetworkConfigurator::computeConfiguration()
 {
-    long initializeStartTime = clock();
+    double initializeStartTime = getWallClockTime();
     topology.clear();
     // extract topology into the IPv4Topology object, then fill in a LinkInfo[] vector
     T(extractTopology(topology));
@@ -1735,392 +1734,289 @@ bool IPv4NetworkConfigurator::containsRoute(const std::vector<IPv4Route *>& rout
     return false;
 }
 
-void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
+class IPv4NetworkConfigurator::NextHopCalculator : public ParallelLoop::Body
 {
-    // TODO: it should be configurable (via xml?) which nodes need static routes filled in automatically
-    // add static routes for all routing tables
-    for (int i = 0; i < topology.getNumNodes(); i++) {
-        Node *sourceNode = (Node *)topology.getNode(i);
-        if (!sourceNode->interfaceTable)
-            continue;
+    public:
+        IPv4NetworkConfigurator *configurator;
+        IPv4Topology *topology;
+        const ReverseGraph *graph;
+        const std::vector<int> *sourceIndices;
+        std::vector<std::vector<NextHop> > *nextHops;
 
-        // calculate shortest paths from everywhere to sourceNode
-        // we are going to use the paths in reverse direction (assuming all links are bidirectional)
-        topology.calculateUnweightedSingleShortestPathsTo(sourceNode);
+    public:
+        virtual void run(int i) { configurator->calculateNextHops(*topology, *graph, (*sourceIndices)[i], (*nextHops)[i]); }
+};
 
-        // check if adding the default routes would be ok (this is an optimization)
-        if (addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
-        {
-          if (sourceNode->interfaceInfos[0]->addDefaultRoute)
-          {
-            InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
-            InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
-            InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
-
-            // add a network route for the local network using ARP
-            IPv4Route *route = new IPv4Route();
-            route->setDestination(sourceInterfaceInfo->getAddress().doAnd(sourceInterfaceInfo->getNetmask()));
-            route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(sourceInterfaceInfo->getNetmask());
-            route->setInterface(sourceInterfaceEntry);
-            route->setSourceType(IPv4Route::MANUAL);
-            sourceNode->staticRoutes.push_back(route);
-
-            // add a default route towards the only one gateway
-            route = new IPv4Route();
-            IPv4Address gateway = gatewayInterfaceInfo->getAddress();
-            route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setGateway(gateway);
-            route->setInterface(sourceInterfaceEntry);
-            route->setSourceType(IPv4Route::MANUAL);
-            sourceNode->staticRoutes.push_back(route);
-
-            // skip building and optimizing the whole routing table
-            EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
-          }
-        }
-        else
-        {
-            // add a route to all destinations in the network
-            for (int j = 0; j < topology.getNumNodes(); j++)
-            {
-                // extract destination
-                Node *destinationNode = (Node *)topology.getNode(j);
-                if (sourceNode == destinationNode)
-                    continue;
-                if (destinationNode->getNumPaths() == 0)
-                    continue;
-                if (!destinationNode->interfaceTable)
-                    continue;
-
-                // determine next hop interface
-                // find next hop interface (the last IP interface on the path that is not in the source node)
-                Node *node = destinationNode;
-                Link *link = NULL;
-                InterfaceInfo *nextHopInterfaceInfo = NULL;
-                while (node != sourceNode)
-                {
-                    link = (Link *)node->getPath(0);
-                    if (node->interfaceTable && node != sourceNode && link->sourceInterfaceInfo)
-                        nextHopInterfaceInfo = link->sourceInterfaceInfo;
-                    node = (Node *)node->getPath(0)->getRemoteNode();
-                }
-
-                // determine source interface
-                if (link->destinationInterfaceInfo && link->destinationInterfaceInfo->addStaticRoute)
-                {
-                    InterfaceEntry *sourceInterfaceEntry = link->destinationInterfaceInfo->interfaceEntry;
-
-                    // add the same routes for all destination interfaces (IP packets are accepted from any interface at the destination)
-                    for (int j = 0; j < (int)destinationNode->interfaceInfos.size(); j++)
-                    {
-                        InterfaceInfo *destinationInterfaceInfo = destinationNode->interfaceInfos[j];
-                        InterfaceEntry *destinationInterfaceEntry = destinationInterfaceInfo->interfaceEntry;
-                        IPv4Address destinationAddress = destinationInterfaceInfo->getAddress();
-                        IPv4Address destinationNetmask = destinationInterfaceInfo->getNetmask();
-                        if (!destinationInterfaceEntry->isLoopback() && !destinationAddress.isUnspecified())
-                        {
-                            IPv4Route *route = new IPv4Route();
-                            IPv4Address gatewayAddress = nextHopInterfaceInfo->getAddress();
-                            if (addSubnetRoutesParameter && destinationNode->interfaceInfos.size() == 1 && destinationNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo
-                                    && destinationNode->interfaceInfos[0]->addSubnetRoute)
-                            {
-                                route->setDestination(destinationAddress.doAnd(destinationNetmask));
-                                route->setNetmask(destinationNetmask);
-                            }
-                            else
-                            {
-                                route->setDestination(destinationAddress);
-                                route->setNetmask(IPv4Address::ALLONES_ADDRESS);
-                            }
-                            route->setInterface(sourceInterfaceEntry);
-                            if (gatewayAddress != destinationAddress)
-                                route->setGateway(gatewayAddress);
-                            route->setSourceType(IPv4Route::MANUAL);
-                            if (containsRoute(sourceNode->staticRoutes, route))
-                                delete route;
-                            else {
-                                sourceNode->staticRoutes.push_back(route);
-                                EV_DEBUG << "Adding route " << sourceInterfaceEntry->getFullPath() << " -> " << destinationInterfaceEntry->getFullPath() << " as " << route->info() << endl;
-                            }
-                        }
-                    }
-                }
-            }
-
-            // optimize routing table to save memory and increase lookup performance
-            if (optimizeRoutesParameter)
-                optimizeRoutes(sourceNode->staticRoutes);
-        }
-    }
-}
-
-/**
- * Returns true if the two routes are the same except their address prefix and netmask.
- * If it returns true we say that the routes have the same color.
- */
-bool IPv4NetworkConfigurator::routesHaveSameColor(IPv4Route *route1, IPv4Route *route2)
-{
-    return route1->getSourceType() == route2->getSourceType() && route1->getMetric() == route2->getMetric() &&
-           route1->getGateway() == route2->getGateway() && route1->getInterface() == route2->getInterface();
-}
-
-/**
- * Returns the index of the first route that has the same color.
- */
-int IPv4NetworkConfigurator::findRouteIndexWithSameColor(const std::vector<IPv4Route *>& routes, IPv4Route *route)
-{
-    for (int i = 0; i < (int)routes.size(); i++)
-        if (routesHaveSameColor(routes[i], route))
-            return i;
-    return -1;
-}
-
-/**
- * Returns true if swapping two ADJACENT routes in the routing table does not change the table's meaning.
- */
-bool IPv4NetworkConfigurator::routesCanBeSwapped(RouteInfo *routeInfo1, RouteInfo *routeInfo2)
+class IPv4NetworkConfigurator::RouteOptimizer : public ParallelLoop::Body
 {
-    if (routeInfo1->color == routeInfo2->color)
-        return true;  // these two routes send the packet in the same direction (same gw/iface), doesn't matter which one we use -> can be swapped
-    else {
-        // unrelated routes can also be swapped
-        uint32 netmask = routeInfo1->netmask & routeInfo2->netmask;
-        return (routeInfo1->destination & netmask) != (routeInfo2->destination & netmask);
-    }
-}
+    public:
+        IPv4NetworkConfigurator *configurator;
+        const std::vector<Node *> *nodes;
 
-/**
- * Returns true if the routes can be neighbors by repeatedly swapping routes
- * in the routing table without changing their meaning.
- */
-bool IPv4NetworkConfigurator::routesCanBeNeighbors(const std::vector<RouteInfo *>& routeInfos, int i, int j)
-{
-    int begin = std::min(i, j);
-    int end = std::max(i, j);
-    IPv4NetworkConfigurator::RouteInfo *beginRouteInfo = routeInfos.at(begin);
-    for (int index = begin + 1; index < end; index++)
-        if (!routesCanBeSwapped(beginRouteInfo, routeInfos.at(index)))
-            return false;
-    return true;
-}
-
-/**
- * Returns true if the original route is interrupted by any of the routes in
- * the routing table between begin and end.
- */
-bool IPv4NetworkConfigurator::interruptsOriginalRoute(const RoutingTableInfo& routingTableInfo, int begin, int end, RouteInfo *originalRouteInfo)
-{
-    IPv4NetworkConfigurator::RouteInfo *matchingRouteInfo = routingTableInfo.findBestMatchingRouteInfo(originalRouteInfo->destination, begin, end);
-    return matchingRouteInfo && matchingRouteInfo->color != originalRouteInfo->color;
-}
+    public:
+        virtual void run(int i) { configurator->optimizeRoutes((*nodes)[i]->staticRoutes); }
+};
 
-/**
- * Returns true if any of the original routes is interrupted by any of the
- * routes in the routing table between begin and end.
- */
-bool IPv4NetworkConfigurator::interruptsAnyOriginalRoute(const RoutingTableInfo& routingTableInfo, int begin, int end, const std::vector<RouteInfo *>& originalRouteInfos)
+void IPv4NetworkConfigurator::buildReverseGraph(IPv4Topology& topology, ReverseGraph& graph)
 {
-    if (begin < end)
-        for (int i = 0; i < (int)originalRouteInfos.size(); i++)
-            if (interruptsOriginalRoute(routingTableInfo, begin, end, originalRouteInfos.at(i)))
-                return true;
-    return false;
-}
+    std::map<Topology::Node *, int> nodeIndices;
+    for (int i = 0; i < topology.getNumNodes(); i++)
+        nodeIndices[topology.getNode(i)] = i;
 
-/**
- * Returns true if any of the original routes attached to the routes in the
- * routing table below index are interrupted by the route at index.
- */
-bool IPv4NetworkConfigurator::interruptsSubsequentOriginalRoutes(const RoutingTableInfo& routingTableInfo, int index)
-{
-    for (int i = index + 1; i < (int)routingTableInfo.routeInfos.size(); i++)
+    graph.inLinkBegin.clear();
+    graph.inLinkSourceNodes.clear();
+    graph.inLinks.clear();
+    for (int i = 0; i < topology.getNumNodes(); i++)
     {
-        IPv4NetworkConfigurator::RouteInfo *routeInfo = routingTableInfo.routeInfos.at(i);
-        if (interruptsAnyOriginalRoute(routingTableInfo, index, index + 1, routeInfo->originalRouteInfos))
-            return true;
+        Node *node = (Node *)topology.getNode(i);
+        graph.inLinkBegin.push_back(graph.inLinks.size());
+        for (int j = 0; j < node->getNumInLinks(); j++)
+        {
+            Topology::LinkIn *linkIn = node->getLinkIn(j);
+            if (linkIn->isEnabled() && linkIn->getRemoteNode()->isEnabled())
+            {
+                graph.inLinkSourceNodes.push_back(nodeIndices[linkIn->getRemoteNode()]);
+                graph.inLinks.push_back((Link *)linkIn);
+            }
+        }
     }
-    return false;
+    graph.inLinkBegin.push_back(graph.inLinks.size());
 }
 
-/**
- * Asserts that all original routes are still routed the same way as by the original routing table.
- */
-void IPv4NetworkConfigurator::checkOriginalRoutes(const RoutingTableInfo& routingTableInfo, const std::vector<RouteInfo *>& originalRouteInfos)
+void IPv4NetworkConfigurator::calculateNextHops(IPv4Topology& topology, const ReverseGraph& graph, int sourceIndex, std::vector<NextHop>& nextHops)
 {
-    // assert that all original routes are routed with the same color
-    for (int i = 0; i < (int)originalRouteInfos.size(); i++)
+    // breadth-first search visiting incoming links in the same order as
+    // Topology::calculateUnweightedSingleShortestPathsTo(), so that the same paths are found.
+    // the next hop of a node is derived from the next hop of its parent in the tree.
+    int numNodes = topology.getNumNodes();
+    nextHops.assign(numNodes, NextHop());
+    std::vector<bool> visited(numNodes, false);
+    std::vector<int> queue;
+    queue.reserve(numNodes);
+    visited[sourceIndex] = true;
+    queue.push_back(sourceIndex);
+    for (int k = 0; k < (int)queue.size(); k++)
     {
-        IPv4NetworkConfigurator::RouteInfo *originalRouteInfo = originalRouteInfos.at(i);
-        IPv4NetworkConfigurator::RouteInfo *matchingRouteInfo = routingTableInfo.findBestMatchingRouteInfo(originalRouteInfo->destination);
-        if (!(matchingRouteInfo && matchingRouteInfo->color == originalRouteInfo->color))
-            ASSERT(false);
+        int v = queue[k];
+        for (int l = graph.inLinkBegin[v]; l < graph.inLinkBegin[v + 1]; l++)
+        {
+            int w = graph.inLinkSourceNodes[l];
+            if (visited[w])
+                continue;
+            visited[w] = true;
+            queue.push_back(w);
+
+            // the next hop interface is the last IP interface on the path that is not in the source node
+            Link *link = graph.inLinks[l];
+            NextHop& nextHop = nextHops[w];
+            nextHop.link = v == sourceIndex ? link : nextHops[v].link;
+            nextHop.nextHopInterfaceInfo = nextHops[v].nextHopInterfaceInfo;
+            if (!nextHop.nextHopInterfaceInfo && ((Node *)topology.getNode(w))->interfaceTable && link->sourceInterfaceInfo)
+                nextHop.nextHopInterfaceInfo = link->sourceInterfaceInfo;
+        }
     }
 }
 
-/**
- * Returns the longest shared address prefix and netmask by iterating through bits from left to right.
- */
-void IPv4NetworkConfigurator::findLongestCommonDestinationPrefix(uint32 destination1, uint32 netmask1, uint32 destination2, uint32 netmask2, uint32& destinationOut, uint32& netmaskOut)
+void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
 {
-    netmaskOut = 0;
-    destinationOut = 0;
-    for (int bitIndex = 31; bitIndex >= 0; bitIndex--)
+    // The shortest paths towards different source nodes are independent, so they are computed
+    // in parallel, a batch of source nodes at a time (storing the paths of all nodes at once would
+    // need memory quadratic in the number of nodes). Routes are added in node order by this thread,
+    // so the result does not depend on the number of threads.
+    int numThreads = numThreadsParameter > 0 ? numThreadsParameter : ParallelLoop::getNumProcessors();
+    int batchSize = 8 * numThreads;
+    double nextHopsTime = 0;
+    double routesTime = 0;
+    ReverseGraph graph;
+    T(buildReverseGraph(topology, graph));
+    std::vector<Node *> optimizedNodes;
+    std::vector<int> sourceIndices;
+    std::vector<std::vector<NextHop> > nextHops;
+
+    // TODO: it should be configurable (via xml?) which nodes need static routes filled in automatically
+    // add static routes for all routing tables
+    for (int batchBegin = 0; batchBegin < topology.getNumNodes(); batchBegin += batchSize)
     {
-        uint32 mask = 1 << bitIndex;
-        if ((destination1 & mask) == (destination2 & mask) &&
-            (netmask1 & mask) != 0 && (netmask2 & mask) != 0)
-        {
-            netmaskOut |= mask;
-            destinationOut |= destination1 & mask;
+        int batchEnd = std::min(batchBegin + batchSize, topology.getNumNodes());
+
+        // calculate shortest paths from everywhere to the source nodes of the batch that need a full routing table
+        // we are going to use the paths in reverse direction (assuming all links are bidirectional)
+        double startTime = getWallClockTime();
+        sourceIndices.clear();
+        for (int i = batchBegin; i < batchEnd; i++) {
+            Node *sourceNode = (Node *)topology.getNode(i);
+            if (sourceNode->interfaceTable && !(addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo))
+                sourceIndices.push_back(i);
         }
-        else
-            break;
+        nextHops.resize(sourceIndices.size());
+        NextHopCalculator nextHopCalculator;
+        nextHopCalculator.configurator = this;
+        nextHopCalculator.topology = &topology;
+        nextHopCalculator.graph = &graph;
+        nextHopCalculator.sourceIndices = &sourceIndices;
+        nextHopCalculator.nextHops = &nextHops;
+        ParallelLoop::run(numThreads, sourceIndices.size(), &nextHopCalculator);
+        nextHopsTime += getWallClockTime() - startTime;
+
+        startTime = getWallClockTime();
+        for (int i = batchBegin, k = 0; i < batchEnd; i++) {
+            Node *sourceNode = (Node *)topology.getNode(i);
+            if (!sourceNode->interfaceTable)
+                continue;
+
+            // check if adding the default routes would be ok (this is an optimization)
+            if (addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
+            {
+              if (sourceNode->interfaceInfos[0]->addDefaultRoute)
+              {
+                InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
+                InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
+                InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
+
+                // add a network route for the local network using ARP
+                IPv4Route *route = new IPv4Route();
+                route->setDestination(sourceInterfaceInfo->getAddress().doAnd(sourceInterfaceInfo->getNetmask()));
+                route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
+                route->setNetmask(sourceInterfaceInfo->getNetmask());
+                route->setInterface(sourceInterfaceEntry);
+                route->setSourceType(IPv4Route::MANUAL);
+                sourceNode->staticRoutes.push_back(route);
+
+                // add a default route towards the only one gateway
+                route = new IPv4Route();
+                IPv4Address gateway = gatewayInterfaceInfo->getAddress();
+                route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
+                route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
+                route->setGateway(gateway);
+                route->setInterface(sourceInterfaceEntry);
+                route->setSourceType(IPv4Route::MANUAL);
+                sourceNode->staticRoutes.push_back(route);
+
+                // skip building and optimizing the whole routing table
+                EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
+              }
+            }
+            else
+            {
+                ASSERT(sourceIndices[k] == i);
+                addStaticRoutes(topology, sourceNode, nextHops[k++]);
+                if (optimizeRoutesParameter)
+                    optimizedNodes.push_back(sourceNode);
+            }
+        }
+        routesTime += getWallClockTime() - startTime;
     }
-}
+    printSpentTime("calculateNextHops", nextHopsTime);
+    printSpentTime("addStaticRoutes(sourceNode)", routesTime);
 
-/**
- * Adds all of the original routes to the matching optimized routes between begin and end.
- */
-void IPv4NetworkConfigurator::addOriginalRouteInfos(RoutingTableInfo& routingTableInfo, int begin, int end, const std::vector<RouteInfo *>& originalRouteInfos)
-{
-    for (int i = 0; i < (int)originalRouteInfos.size(); i++)
+    // optimize routing tables to save memory and increase lookup performance
+    if (!optimizedNodes.empty())
     {
-        IPv4NetworkConfigurator::RouteInfo *originalRouteInfo = originalRouteInfos.at(i);
-        IPv4NetworkConfigurator::RouteInfo *matchingRouteInfo = routingTableInfo.findBestMatchingRouteInfo(originalRouteInfo->destination, begin, end);
-        ASSERT(matchingRouteInfo && matchingRouteInfo->color == originalRouteInfo->color);
-        matchingRouteInfo->originalRouteInfos.push_back(originalRouteInfo);
+        double startTime = getWallClockTime();
+        RouteOptimizer routeOptimizer;
+        routeOptimizer.configurator = this;
+        routeOptimizer.nodes = &optimizedNodes;
+        ParallelLoop::run(numThreads, optimizedNodes.size(), &routeOptimizer);
+        printElapsedTime("optimizeRoutes", startTime);
     }
 }
 
-/**
- * Try to merge two routes that have the same color and could be neighbours in table
- * without changing the table's meaning. There are two merge opportunities:
- * (1) one route's network contains the other one (then the second can be dropped),
- * and (2) use a shorter common prefix that covers both (this is only possible
- * if this doesn't interfere with existing routes in the table).
- * Returns true if the two routes have been merged, otherwise returns false.
- */
-bool IPv4NetworkConfigurator::tryToMergeTwoRoutes(RoutingTableInfo& routingTableInfo, int i, int j, RouteInfo *routeInfoI, RouteInfo *routeInfoJ)
-{
-    // determine longest shared address prefix and netmask by iterating through bits from left to right
-    uint32 netmask;
-    uint32 destination;
-    findLongestCommonDestinationPrefix(routeInfoI->destination, routeInfoI->netmask, routeInfoJ->destination, routeInfoJ->netmask, destination, netmask);
-
-    // create the merged route
-    RouteInfo *mergedRouteInfo = new RouteInfo(routeInfoI->color, destination, netmask);
-    routeInfoI->enabled = false;
-    routeInfoJ->enabled = false;
-    int m = routingTableInfo.addRouteInfo(mergedRouteInfo);
-    ASSERT(m > i && m > j);
-
-    // check if all the original routes are still routed the same way by the optimized routing table.
-    // check optimization: instead of checking all the original routes, check only those which can go wrong due to the merge.
-    // (assuming the previous configuration was correct)
-    //  - the original routes on I and J are going to be routed by M after the merge, so check if the routes in between don't interrupt them
-    //  - the original routes following M can be accidentally overridden by M (being larger than the sum of I and J), so verify that M does not interrupt them
-    // note that the condition is not symmetric because I follows J so it requires fewer checks and we do use that.
-    if (!interruptsAnyOriginalRoute(routingTableInfo, j + 1, i, routeInfoJ->originalRouteInfos) && // check that original routes on J are not interrupted between J and I
-        !interruptsAnyOriginalRoute(routingTableInfo, i + 1, m, routeInfoJ->originalRouteInfos) && // check that original routes on J are not interrupted between I and M
-        !interruptsAnyOriginalRoute(routingTableInfo, i + 1, m, routeInfoI->originalRouteInfos) && // check that original routes on I are not interrupted between I and M
-        !interruptsSubsequentOriginalRoutes(routingTableInfo, m)) // check that the original routes after M are not interrupted by M
+void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology, Node *sourceNode, const std::vector<NextHop>& nextHops)
+{
+    // add a route to all destinations in the network
+    for (int j = 0; j < topology.getNumNodes(); j++)
     {
-        // now we know that the merge does not conflict with any route in the routing table.
-        // the next thing to do is to maintain the original routes attached to the optimized ones.
-        // move original routes from the to be deleted I route to the capturing routes.
-        addOriginalRouteInfos(routingTableInfo, i + 1, m + 1, routeInfoI->originalRouteInfos);
+        // extract destination
+        Node *destinationNode = (Node *)topology.getNode(j);
+        if (sourceNode == destinationNode)
+            continue;
+        if (!nextHops[j].link)
+            continue;
+        if (!destinationNode->interfaceTable)
+            continue;
 
-        // move original routes from the to be deleted J route to the capturing routes.
-        addOriginalRouteInfos(routingTableInfo, j + 1, m + 1, routeInfoJ->originalRouteInfos);
+        // next hop interface and the last link of the path (arriving at the source node)
+        Link *link = nextHops[j].link;
+        InterfaceInfo *nextHopInterfaceInfo = nextHops[j].nextHopInterfaceInfo;
 
-        // move original routes from the routes following the merged one if necessary.
-        for (int k = m + 1; k < (int)routingTableInfo.routeInfos.size(); k++)
+        // determine source interface
+        if (link->destinationInterfaceInfo && link->destinationInterfaceInfo->addStaticRoute)
         {
-            IPv4NetworkConfigurator::RouteInfo *followingRouteInfo = routingTableInfo.routeInfos.at(k);
-            for (int l = 0; l < (int)followingRouteInfo->originalRouteInfos.size(); l++)
+            InterfaceEntry *sourceInterfaceEntry = link->destinationInterfaceInfo->interfaceEntry;
+
+            // add the same routes for all destination interfaces (IP packets are accepted from any interface at the destination)
+            for (int j = 0; j < (int)destinationNode->interfaceInfos.size(); j++)
             {
-                IPv4NetworkConfigurator::RouteInfo *originalRouteInfo = followingRouteInfo->originalRouteInfos.at(l);
-                if (!((originalRouteInfo->destination ^ mergedRouteInfo->destination) & mergedRouteInfo->netmask))
+                InterfaceInfo *destinationInterfaceInfo = destinationNode->interfaceInfos[j];
+                InterfaceEntry *destinationInterfaceEntry = destinationInterfaceInfo->interfaceEntry;
+                IPv4Address destinationAddress = destinationInterfaceInfo->getAddress();
+                IPv4Address destinationNetmask = destinationInterfaceInfo->getNetmask();
+                if (!destinationInterfaceEntry->isLoopback() && !destinationAddress.isUnspecified())
                 {
-                    followingRouteInfo->originalRouteInfos.erase(followingRouteInfo->originalRouteInfos.begin() + l);
-                    ASSERT(mergedRouteInfo->color == originalRouteInfo->color);
-                    mergedRouteInfo->originalRouteInfos.push_back(originalRouteInfo);
-                    l--;
+                    IPv4Route *route = new IPv4Route();
+                    IPv4Address gatewayAddress = nextHopInterfaceInfo->getAddress();
+                    if (addSubnetRoutesParameter && destinationNode->interfaceInfos.size() == 1 && destinationNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo
+                            && destinationNode->interfaceInfos[0]->addSubnetRoute)
+                    {
+                        route->setDestination(destinationAddress.doAnd(destinationNetmask));
+                        route->setNetmask(destinationNetmask);
+                    }
+                    else
+                    {
+                        route->setDestination(destinationAddress);
+                        route->setNetmask(IPv4Address::ALLONES_ADDRESS);
+                    }
+                    route->setInterface(sourceInterfaceEntry);
+                    if (gatewayAddress != destinationAddress)
+                        route->setGateway(gatewayAddress);
+                    route->setSourceType(IPv4Route::MANUAL);
+                    if (containsRoute(sourceNode->staticRoutes, route))
+                        delete route;
+                    else {
+                        sourceNode->staticRoutes.push_back(route);
+                        EV_DEBUG << "Adding route " << sourceInterfaceEntry->getFullPath() << " -> " << destinationInterfaceEntry->getFullPath() << " as " << route->info() << endl;
+                    }
                 }
             }
         }
-        routingTableInfo.removeRouteInfo(routeInfoI);
-        routingTableInfo.removeRouteInfo(routeInfoJ);
-#ifndef NDEBUG
-        //checkOriginalRoutes(routingTableInfo, originalRouteInfos);
-#endif
-        delete routeInfoI;
-        delete routeInfoJ;
-        return true;
-    }
-    else
-    {
-        // merge failed; restore original state
-        routeInfoI->enabled = true;
-        routeInfoJ->enabled = true;
-        routingTableInfo.removeRouteInfo(mergedRouteInfo);
-        delete mergedRouteInfo;
-        return false;
     }
 }
 
 /**
- * Iteratively checks if any two routes can be aggressively merged without changing the meaning of all original routes.
- * The merged route will have the longest shared address prefix and netmask with the two merged routes.
- * This optimization might change the meaning of the routing table in that it will route packets that it did not route before.
- * Nevertheless, any packet routed by the original routing table will still be routed the same way by the optimized routing table.
- * Returns true if two routes has been merged, otherwise returns false.
+ * Returns true if the two routes are the same except their address prefix and netmask.
+ * If it returns true we say that the routes have the same color.
  */
-bool IPv4NetworkConfigurator::tryToMergeAnyTwoRoutes(RoutingTableInfo& routingTableInfo)
+bool IPv4NetworkConfigurator::routesHaveSameColor(IPv4Route *route1, IPv4Route *route2)
 {
-    for (int i = 0; i < (int)routingTableInfo.routeInfos.size(); i++)
-    {
-        IPv4NetworkConfigurator::RouteInfo *routeInfoI = routingTableInfo.routeInfos.at(i);
-
-        // iterate backward so that we try to merge routes having longer netmasks first.
-        // this results in smaller changes and allows more symmetric optimization.
-        for (int j = i - 1; j >= 0; j--)
-        {
-            IPv4NetworkConfigurator::RouteInfo *routeInfoJ = routingTableInfo.routeInfos.at(j);
+    return route1->getSourceType() == route2->getSourceType() && route1->getMetric() == route2->getMetric() &&
+           route1->getGateway() == route2->getGateway() && route1->getInterface() == route2->getInterface();
+}
 
-            // we can only merge neighbor routes having the same color
-            if (routeInfoI->color == routeInfoJ->color && routesCanBeNeighbors(routingTableInfo.routeInfos, i, j))
-            {
-                // it is worth to actually try to merge them
-                if (tryToMergeTwoRoutes(routingTableInfo, i, j, routeInfoI, routeInfoJ))
-                    return true;
-            }
-        }
-    }
-    return false;
+/**
+ * Returns the index of the first route that has the same color.
+ */
+int IPv4NetworkConfigurator::findRouteIndexWithSameColor(const std::vector<IPv4Route *>& routes, IPv4Route *route)
+{
+    for (int i = 0; i < (int)routes.size(); i++)
+        if (routesHaveSameColor(routes[i], route))
+            return i;
+    return -1;
 }
 
 void IPv4NetworkConfigurator::optimizeRoutes(std::vector<IPv4Route *>& originalRoutes)
 {
-    // The basic idea: if two routes "do the same" (same output interface, gateway, etc) and
-    // match "similar" addresses, one can try to move them to be neighbors in the table and
-    // replace them with a single route which contains their longest common prefix as address
-    // prefix -- provided that this operation doesn't affect the meaning of the routing table
-    // for "existing" addresses. (We don't care about changing the routing for addresses that
-    // we know don't occur in our currently configured network.) We can repeatedly merge routes
-    // in this way until it's not possible any more. Of course, the result also depends on
-    // which pairs of routes we merge, and in which order.
+    // The basic idea: routes that "do the same" (same output interface, gateway, etc) are
+    // given the same color, and the routing table is rebuilt from a binary trie of the
+    // destination prefixes: sibling prefixes of the same color are merged into their covering
+    // prefix, and routes are only kept where the color differs from the covering route.
+    // The resulting table routes every address that the original table routes the same way.
+    // (We don't care about changing the routing for addresses that no original route matches,
+    // those don't occur in our currently configured network.) See IPv4RouteAggregator.
 
     // STEP 1.
-    // instead of working with IPv4 routes we transform them into the internal representation of the optimizer.
     // routes are classified based on their action (gateway, interface, type, source, metric, etc.) and a color is assigned to them.
-    RoutingTableInfo routingTableInfo;
     std::vector<IPv4Route *> colorToRoute;  // a mapping from color to route action (interface, gateway, metric, etc.)
-    std::vector<RouteInfo *> originalRouteInfos; // a copy of the original routes in the optimizer's format
-
-    // build colorToRouteColor, originalRouteInfos and initial routeInfos in routingTableInfo
+    IPv4RouteAggregator routeAggregator;
     for (int i = 0; i < (int)originalRoutes.size(); i++)
     {
         IPv4Route *originalRoute = originalRoutes.at(i);
@@ -2130,46 +2026,30 @@ void IPv4NetworkConfigurator::optimizeRoutes(std::vector<IPv4Route *>& originalR
             color = colorToRoute.size();
             colorToRoute.push_back(originalRoute);
         }
-
-        // create original route and determine its color
-        RouteInfo *originalRouteInfo = new RouteInfo(color, originalRoute->getDestination().getInt(), originalRoute->getNetmask().getInt());
-        originalRouteInfos.push_back(originalRouteInfo);
-
-        // create a copy of the original route that can be destructively optimized later
-        RouteInfo *optimizedRouteInfo = new RouteInfo(*originalRouteInfo);
-        optimizedRouteInfo->originalRouteInfos.push_back(originalRouteInfo);
-        routingTableInfo.addRouteInfo(optimizedRouteInfo);
+        int prefixLength = originalRoute->getNetmask().getNetmaskLength();
+        routeAggregator.addRoute(originalRoute->getDestination().getInt() & IPv4Address::makeNetmask(prefixLength).getInt(), prefixLength, color);
     }
 
-#ifndef NDEBUG
-    checkOriginalRoutes(routingTableInfo, originalRouteInfos);
-#endif
-
     // STEP 2.
-    // from now on we are only working with the internal data structures called RouteInfo and RoutingTableInfo.
-    // the main optimizer loop runs until it cannot merge any two routes.
-    while (tryToMergeAnyTwoRoutes(routingTableInfo));
-
-#ifndef NDEBUG
-    checkOriginalRoutes(routingTableInfo, originalRouteInfos);
-#endif
+    // aggregate the routes in the trie
+    std::vector<IPv4RouteAggregator::Route> aggregatedRoutes;
+    routeAggregator.aggregate(aggregatedRoutes);
 
     // STEP 3.
     // convert the optimized routes to new optimized IPv4 routes based on the saved colors
     std::vector<IPv4Route *> optimizedRoutes;
-    for (int i = 0; i < (int)routingTableInfo.routeInfos.size(); i++)
+    for (int i = 0; i < (int)aggregatedRoutes.size(); i++)
     {
-        RouteInfo *routeInfo = routingTableInfo.routeInfos.at(i);
-        IPv4Route *routeColor = colorToRoute[routeInfo->color];
+        const IPv4RouteAggregator::Route& aggregatedRoute = aggregatedRoutes[i];
+        IPv4Route *routeColor = colorToRoute[aggregatedRoute.color];
         IPv4Route *optimizedRoute = new IPv4Route();
-        optimizedRoute->setDestination(IPv4Address(routeInfo->destination));
-        optimizedRoute->setNetmask(IPv4Address(routeInfo->netmask));
+        optimizedRoute->setDestination(IPv4Address(aggregatedRoute.destination));
+        optimizedRoute->setNetmask(IPv4Address::makeNetmask(aggregatedRoute.prefixLength));
         optimizedRoute->setInterface(routeColor->getInterface());
         optimizedRoute->setGateway(routeColor->getGateway());
         optimizedRoute->setSourceType(routeColor->getSourceType());
         optimizedRoute->setMetric(routeColor->getMetric());
         optimizedRoutes.push_back(optimizedRoute);
-        delete routeInfo;
     }
 
     // delete original routes, we destructively modify them
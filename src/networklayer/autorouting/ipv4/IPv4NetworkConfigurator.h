@@ -133,36 +133,32 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
         };
 
         /**
-         * Simplified route representation used by the optimizer.
-         * This class makes the optimization faster by introducing route coloring.
+         * Reverse adjacency lists of the topology where nodes are identified by their
+         * index in the topology. Only enabled links between enabled nodes are present.
+         * Read-only while shortest paths are computed in parallel.
          */
-        class RouteInfo {
+        class ReverseGraph {
             public:
-                int color;          // an index into an array representing the different route actions (gateway, interface, metric, etc.)
-                bool enabled;       // allows turning of routes without removing them from the list
-                uint32 destination; // originally copied from the IPv4Route
-                uint32 netmask;     // originally copied from the IPv4Route
-                std::vector<RouteInfo *> originalRouteInfos; // routes that are routed by this one from the unoptimized original routing table, we keep track of this to be able to skip merge candidates with less computation
-
-            public:
-                RouteInfo(int color, uint32 destination, uint32 netmask) { this->color = color; this->enabled = true; this->destination = destination; this->netmask = netmask; }
+                std::vector<int> inLinkBegin;       // incoming links of node i are at [inLinkBegin[i], inLinkBegin[i+1])
+                std::vector<int> inLinkSourceNodes; // index of the node the link starts from
+                std::vector<Link *> inLinks;
         };
 
         /**
-         * Simplified routing table representation used by the optimizer.
+         * Result of the shortest path computation towards a source node for a single destination node.
          */
-        class RoutingTableInfo {
+        class NextHop {
             public:
-                std::vector<RouteInfo *> routeInfos; // list of routes in the routing table
+                Link *link;                             // the last link on the path, arriving at the source node; NULL if there is no path
+                InterfaceInfo *nextHopInterfaceInfo;    // the last IP interface on the path that is not in the source node
 
             public:
-                int addRouteInfo(RouteInfo *routeInfo);
-                void removeRouteInfo(const RouteInfo *routeInfo) { routeInfos.erase(std::find(routeInfos.begin(), routeInfos.end(), routeInfo)); }
-                RouteInfo *findBestMatchingRouteInfo(const uint32 destination) const { return findBestMatchingRouteInfo(destination, 0, routeInfos.size()); }
-                RouteInfo *findBestMatchingRouteInfo(const uint32 destination, int begin, int end) const;
-                static bool routeInfoLessThan(const RouteInfo *a, const RouteInfo *b) { return a->netmask != b->netmask ? a->netmask > b->netmask : a->destination < b->destination; }
+                NextHop() { link = NULL; nextHopInterfaceInfo = NULL; }
         };
 
+        class NextHopCalculator;
+        class RouteOptimizer;
+
         class Matcher
         {
             protected:
@@ -200,6 +196,7 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
         bool addSubnetRoutesParameter;
         bool addDefaultRoutesParameter;
         bool optimizeRoutesParameter;
+        int numThreadsParameter;
         cXMLElement *configuration;
 
         // internal state
@@ -272,17 +269,34 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
 
         /**
          * Adds static routes to all routing tables in the network.
-         * The algorithm uses Dijkstra's weighted shortest path algorithm.
+         * The algorithm uses unweighted (hop count) shortest paths; the paths
+         * towards different source nodes are computed in parallel.
          * May add default routes and subnet routes if possible and requested.
          */
         virtual void addStaticRoutes(IPv4Topology& topology);
 
+        /**
+         * Adds static routes to all destinations to the routing table of sourceNode,
+         * using the next hops computed by calculateNextHops().
+         */
+        virtual void addStaticRoutes(IPv4Topology& topology, Node *sourceNode, const std::vector<NextHop>& nextHops);
+
+        /**
+         * Computes the shortest paths from all nodes to the given source node, and stores
+         * the first hop of each path as seen from the source node. Finds the same paths
+         * as Topology::calculateUnweightedSingleShortestPathsTo(), but does not modify
+         * the topology, so it may be called from several threads at once.
+         */
+        virtual void calculateNextHops(IPv4Topology& topology, const ReverseGraph& graph, int sourceIndex, std::vector<NextHop>& nextHops);
+        virtual void buildReverseGraph(IPv4Topology& topology, ReverseGraph& graph);
+
         /**
          * Destructively optimizes the given IPv4 routes by merging some of them.
          * The resulting routes might be different in that they will route packets
          * that the original routes did not. Nevertheless the following invariant
          * holds: any packet routed by the original routes will still be routed
-         * the same way by the optimized routes.
+         * the same way by the optimized routes. Runs in time linear in the number
+         * of routes (see IPv4RouteAggregator).
          */
         virtual void optimizeRoutes(std::vector<IPv4Route *> &routes);
 
@@ -331,16 +345,6 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
         bool containsRoute(const std::vector<IPv4Route *>& routes, IPv4Route *route);
         bool routesHaveSameColor(IPv4Route *route1, IPv4Route *route2);
         int findRouteIndexWithSameColor(const std::vector<IPv4Route *>& routes, IPv4Route *route);
-        bool routesCanBeSwapped(RouteInfo *routeInfo1, RouteInfo *routeInfo2);
-        bool routesCanBeNeighbors(const std::vector<RouteInfo *>& routeInfos, int i, int j);
-        bool interruptsOriginalRoute(const RoutingTableInfo& routingTableInfo, int begin, int end, RouteInfo *originalRouteInfo);
-        bool interruptsAnyOriginalRoute(const RoutingTableInfo& routingTableInfo, int begin, int end, const std::vector<RouteInfo *>& originalRouteInfos);
-        bool interruptsSubsequentOriginalRoutes(const RoutingTableInfo& routingTableInfo, int index);
-        void checkOriginalRoutes(const RoutingTableInfo& routingTableInfo, const std::vector<RouteInfo *>& originalRouteInfos);
-        void findLongestCommonDestinationPrefix(uint32 destination1, uint32 netmask1, uint32 destination2, uint32 netmask2, uint32& destinationOut, uint32& netmaskOut);
-        void addOriginalRouteInfos(RoutingTableInfo& routingTableInfo, int begin, int end, const std::vector<RouteInfo *>& originalRouteInfos);
-        bool tryToMergeTwoRoutes(RoutingTableInfo& routingTableInfo, int i, int j, RouteInfo *routeInfoI, RouteInfo *routeInfoJ);
-        bool tryToMergeAnyTwoRoutes(RoutingTableInfo& routingTableInfo);
 
     public:
         // address resolver interface
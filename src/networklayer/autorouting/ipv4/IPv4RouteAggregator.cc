@@ -0,0 +1,147 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+
+#include "IPv4RouteAggregator.h"
+
+
+void IPv4RouteAggregator::clear()
+{
+    nodes.clear();
+    nodes.push_back(Node());
+}
+
+int IPv4RouteAggregator::addChild(int parent, int bit)
+{
+    int index = nodes.size();
+    nodes.push_back(Node());
+    nodes[parent].child[bit] = index;
+    return index;
+}
+
+void IPv4RouteAggregator::addRoute(uint32 destination, int prefixLength, int color)
+{
+    ASSERT(prefixLength >= 0 && prefixLength <= 32);
+    ASSERT(color >= 0);
+
+    int index = 0;
+    for (int i = 0; i < prefixLength; i++)
+    {
+        int bit = (destination >> (31 - i)) & 1;
+        int child = nodes[index].child[bit];
+        index = child != -1 ? child : addChild(index, bit);
+    }
+    if (nodes[index].color == -1)
+        nodes[index].color = color;
+}
+
+void IPv4RouteAggregator::completeTrie(int index, int inheritedColor)
+{
+    if (nodes[index].color != -1)
+        inheritedColor = nodes[index].color;
+
+    int child0 = nodes[index].child[0];
+    int child1 = nodes[index].child[1];
+    if (child0 == -1 && child1 == -1)
+    {
+        // leaf: the longest matching original route decides
+        nodes[index].color = inheritedColor;
+        return;
+    }
+
+    // the missing child covers addresses that are routed by the longest matching ancestor route
+    if (child0 == -1)
+        nodes[addChild(index, 0)].color = inheritedColor;
+    else
+        completeTrie(child0, inheritedColor);
+    if (child1 == -1)
+        nodes[addChild(index, 1)].color = inheritedColor;
+    else
+        completeTrie(child1, inheritedColor);
+}
+
+void IPv4RouteAggregator::collectColors(int index)
+{
+    Node& node = nodes[index];
+    if (node.child[0] == -1)
+    {
+        // leaf (completeTrie() made sure that internal nodes have two children)
+        node.dontCare = node.color == -1;
+        if (!node.dontCare)
+            node.colors.push_back(node.color);
+        return;
+    }
+
+    collectColors(node.child[0]);
+    collectColors(node.child[1]);
+    Node& a = nodes[node.child[0]];
+    Node& b = nodes[node.child[1]];
+    if (a.dontCare || b.dontCare)
+    {
+        // don't care is the neutral element of both intersection and union
+        node.dontCare = a.dontCare && b.dontCare;
+        node.colors = a.dontCare ? b.colors : a.colors;
+    }
+    else
+    {
+        std::set_intersection(a.colors.begin(), a.colors.end(), b.colors.begin(), b.colors.end(), std::back_inserter(node.colors));
+        if (node.colors.empty())
+            std::set_union(a.colors.begin(), a.colors.end(), b.colors.begin(), b.colors.end(), std::back_inserter(node.colors));
+    }
+}
+
+void IPv4RouteAggregator::selectRoutes(int index, uint32 destination, int prefixLength, int inheritedColor, std::vector<Route>& routes)
+{
+    const Node& node = nodes[index];
+    if (node.dontCare)
+        return;
+
+    // a route is not placed on a prefix one half of which no original route covers:
+    // it would add routes for addresses that had none (e.g. a 0.0.0.0/0 route for a
+    // table without a default route); the other child gets the route instead
+    bool hasChildren = node.child[0] != -1;
+    bool canRoute = !hasChildren || (!nodes[node.child[0]].dontCare && !nodes[node.child[1]].dontCare);
+
+    int color = inheritedColor;
+    if (canRoute && (color == -1 || !std::binary_search(node.colors.begin(), node.colors.end(), color)))
+    {
+        color = node.colors.front();
+        routes.push_back(Route(destination, prefixLength, color));
+    }
+
+    if (hasChildren)
+    {
+        selectRoutes(node.child[0], destination, prefixLength + 1, color, routes);
+        selectRoutes(node.child[1], destination | (0x80000000u >> prefixLength), prefixLength + 1, color, routes);
+    }
+}
+
+bool IPv4RouteAggregator::routeLessThan(const Route& a, const Route& b)
+{
+    return a.prefixLength != b.prefixLength ? a.prefixLength > b.prefixLength : a.destination < b.destination;
+}
+
+void IPv4RouteAggregator::aggregate(std::vector<Route>& routes)
+{
+    routes.clear();
+    completeTrie(0, -1);
+    collectColors(0);
+    selectRoutes(0, 0, 0, -1, routes);
+    std::sort(routes.begin(), routes.end(), routeLessThan);
+    clear();
+}
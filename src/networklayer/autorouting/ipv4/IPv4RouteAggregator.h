@@ -0,0 +1,103 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPv4ROUTEAGGREGATOR_H
+#define __INET_IPv4ROUTEAGGREGATOR_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+
+/**
+ * Computes a small IPv4 routing table that forwards every address covered by
+ * a given set of routes the same way as the original routes do (longest prefix
+ * match). Routes are reduced to a color that identifies their action (gateway,
+ * interface, etc.). Addresses not covered by any original route are "don't care":
+ * the result may route them arbitrarily.
+ *
+ * This is the ORTC algorithm (Draves et al., "Constructing Optimal IP Routing
+ * Tables") extended with don't care addresses, on a binary trie of the prefixes:
+ *  -# the trie is completed so that every node has zero or two children, and
+ *     every leaf gets the color of its longest matching original route (or
+ *     don't care);
+ *  -# bottom-up, every node gets the set of colors that are best for it: the
+ *     intersection of the children's sets if not empty, otherwise their union
+ *     (don't care acts as the set of all colors);
+ *  -# top-down, a route is emitted wherever the color inherited from above is
+ *     not in the node's set.
+ *
+ * Unlike plain ORTC, no route is emitted for a prefix one half of which contains
+ * only don't care addresses; the route goes to the other half instead. So don't
+ * care addresses are only routed inside prefixes whose both halves contain original
+ * routes, and in particular the result contains a 0.0.0.0/0 route only if the
+ * original routes cover the whole address space (e.g. there is a default route).
+ *
+ * The running time is linear in the size of the trie, that is, O(32 * number of routes)
+ * times the number of colors.
+ */
+class INET_API IPv4RouteAggregator
+{
+  public:
+    struct Route
+    {
+        uint32 destination;
+        int prefixLength;
+        int color;
+        Route(uint32 destination, int prefixLength, int color) : destination(destination), prefixLength(prefixLength), color(color) {}
+    };
+
+  protected:
+    struct Node
+    {
+        int child[2];               // indices into nodes, -1 if none
+        int color;                  // color of the route with exactly this prefix, -1 if none
+        bool dontCare;              // the candidate set contains all colors
+        std::vector<int> colors;    // the candidate set (sorted) if !dontCare
+        Node() : color(-1), dontCare(false) { child[0] = child[1] = -1; }
+    };
+
+    std::vector<Node> nodes;    // nodes[0] is the root (0.0.0.0/0)
+
+  protected:
+    int addChild(int parent, int bit);
+    void completeTrie(int index, int inheritedColor);
+    void collectColors(int index);
+    void selectRoutes(int index, uint32 destination, int prefixLength, int inheritedColor, std::vector<Route>& routes);
+    static bool routeLessThan(const Route& a, const Route& b);
+
+  public:
+    IPv4RouteAggregator() { clear(); }
+
+    /** Removes all routes. */
+    void clear();
+
+    /**
+     * Adds an original route with a non-negative color. If a route with the same
+     * prefix was added before, the new one is ignored (it would never match).
+     */
+    void addRoute(uint32 destination, int prefixLength, int color);
+
+    /**
+     * Computes the aggregated routes and stores them in routes, ordered by decreasing
+     * prefix length and then by increasing destination. Consumes the added routes.
+     */
+    void aggregate(std::vector<Route>& routes);
+};
+
+#endif
+
@@ -0,0 +1,35 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "InterfaceAddressIndex.h"
+
+
+uint32 InterfaceAddressIndex::AddressHash::operator()(const IPvXAddress& address) const
+{
+    // multiplicative hashing over the words of the address
+    const uint32 *w = address.words();
+    uint32 h = address.isIPv6() ? 0x9e3779b9u : 0;
+    for (int i = 0; i < address.wordCount(); i++)
+        h = (h ^ w[i]) * 0x9e3779b1u;
+    return h ^ (h >> 16);
+}
+
+InterfaceEntry *InterfaceAddressIndex::find(const IPvXAddress& address) const
+{
+    InterfaceEntry * const *ie = table.find(address);
+    return ie ? *ie : NULL;
+}
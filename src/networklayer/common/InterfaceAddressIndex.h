@@ -0,0 +1,62 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_INTERFACEADDRESSINDEX_H
+#define __INET_INTERFACEADDRESSINDEX_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPvXAddress.h"
+#include "OpenAddressingTable.h"
+
+class InterfaceEntry;
+
+
+/**
+ * Maps IPv4 and IPv6 addresses to the interface they are assigned to, in
+ * an OpenAddressingTable. Used by InterfaceTable to answer
+ * findInterfaceByAddress() in O(1).
+ *
+ * The index only supports insertion; InterfaceTable rebuilds it from
+ * scratch after interface changes, which are rare compared to lookups.
+ */
+class INET_API InterfaceAddressIndex
+{
+  protected:
+    struct AddressHash
+    {
+        uint32 operator()(const IPvXAddress& address) const;
+    };
+
+    OpenAddressingTable<IPvXAddress, InterfaceEntry *, AddressHash> table;
+
+  public:
+    /** Removes all entries. */
+    void clear() { table.clear(); }
+
+    /** Maps address to ie, unless the address is already in the table (the first interface wins). */
+    void insert(const IPvXAddress& address, InterfaceEntry *ie) { ASSERT(ie); table.insert(address, ie); }
+
+    /** Returns the interface the address belongs to, or NULL. */
+    InterfaceEntry *find(const IPvXAddress& address) const;
+
+    int size() const { return table.size(); }
+};
+
+#endif
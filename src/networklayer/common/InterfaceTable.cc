@@ -54,6 +54,7 @@ InterfaceTable::InterfaceTable()
     nb = NULL;
     tmpNumInterfaces = -1;
     tmpInterfaceList = NULL;
+    isAddressIndexValid = false;
 }
 
 InterfaceTable::~InterfaceTable()
@@ -120,32 +121,38 @@ bool InterfaceTable::isLocalAddress(const IPvXAddress& address) const
 
 InterfaceEntry *InterfaceTable::findInterfaceByAddress(const IPvXAddress& address) const
 {
-    if (!address.isUnspecified())
+    if (address.isUnspecified())
+        return NULL;
+    if (!isAddressIndexValid)
+        rebuildAddressIndex();
+    return addressIndex.find(address);
+}
+
+void InterfaceTable::rebuildAddressIndex() const
+{
+    // interfaces are added in id order, so the lowest id wins if an address is assigned to several interfaces
+    addressIndex.clear();
+    for (int i = 0; i < (int)idToInterface.size(); i++)
     {
-        for (int i = 0; i < (int)idToInterface.size(); i++)
+        InterfaceEntry *ie = idToInterface[i];
+        if (ie)
         {
-            InterfaceEntry *ie = idToInterface[i];
-            if (ie)
-            {
 #ifdef WITH_IPv4
-                if (!address.isIPv6())
-                {
-                    if (ie->ipv4Data() && ie->ipv4Data()->getIPAddress() == address.get4())
-                        return ie;
-                }
+            if (ie->ipv4Data() && !ie->ipv4Data()->getIPAddress().isUnspecified())
+                addressIndex.insert(ie->ipv4Data()->getIPAddress(), ie);
 #endif
 
 #ifdef WITH_IPv6
-                if (address.isIPv6())
-                {
-                    if (ie->ipv6Data() && ie->ipv6Data()->hasAddress(address.get6()))
-                        return ie;
-                }
-#endif
+            if (ie->ipv6Data())
+            {
+                IPv6InterfaceData *ipv6Data = ie->ipv6Data();
+                for (int j = 0; j < ipv6Data->getNumAddresses(); j++)
+                    addressIndex.insert(ipv6Data->getAddress(j), ie);
             }
+#endif
         }
     }
-    return NULL;
+    isAddressIndexValid = true;
 }
 
 bool InterfaceTable::isNeighborAddress(const IPvXAddress &address) const
@@ -253,6 +260,7 @@ void InterfaceTable::addInterface(InterfaceEntry *entry)
     entry->setInterfaceTable(this);
     idToInterface.push_back(entry);
     invalidateTmpInterfaceList();
+    isAddressIndexValid = false;
 
     // fill in networkLayerGateIndex, nodeOutputGateId, nodeInputGateId
     discoverConnectingGates(entry);
@@ -331,6 +339,7 @@ void InterfaceTable::deleteInterface(InterfaceEntry *entry)
     idToInterface[id - INTERFACEIDS_START] = NULL;
     delete entry;
     invalidateTmpInterfaceList();
+    isAddressIndexValid = false;
 }
 
 void InterfaceTable::invalidateTmpInterfaceList()
@@ -344,6 +353,10 @@ void InterfaceTable::interfaceChanged(int category, const InterfaceEntryChangeDe
 {
     Enter_Method_Silent();
 
+    // up/down state changes do not affect the assigned addresses
+    if (category != NF_INTERFACE_STATE_CHANGED)
+        isAddressIndexValid = false;
+
     nb->fireChangeNotification(category, details);
 
     if (ev.isGUI() && par("displayAddresses").boolValue())
@@ -497,4 +510,5 @@ void InterfaceTable::resetInterfaces()
     for (int i = 0; i < n; i++)
         if (idToInterface[i])
             idToInterface[i]->resetInterface();
+    isAddressIndexValid = false;  // resetInterface() drops the protocol data without notification
 }
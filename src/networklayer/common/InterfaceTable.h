@@ -23,6 +23,7 @@
 #include "INETDefs.h"
 
 #include "IInterfaceTable.h"
+#include "InterfaceAddressIndex.h"
 #include "InterfaceEntry.h"
 #include "NotificationBoard.h"
 #include "ILifecycle.h"
@@ -80,6 +81,10 @@ class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, pr
     int tmpNumInterfaces; // caches number of non-NULL elements of idToInterface; -1 if invalid
     InterfaceEntry **tmpInterfaceList; // caches non-NULL elements of idToInterface; NULL if invalid
 
+    // supports findInterfaceByAddress(); rebuilt on demand after interface (address) changes
+    mutable InterfaceAddressIndex addressIndex;
+    mutable bool isAddressIndexValid;
+
   protected:
     // displays summary above the icon
     virtual void updateDisplayString();
@@ -96,6 +101,9 @@ class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, pr
     // internal
     virtual void invalidateTmpInterfaceList();
 
+    // fills addressIndex from the IPv4/IPv6 addresses of the interfaces
+    virtual void rebuildAddressIndex() const;
+
     virtual void resetInterfaces();
 
   public:
@@ -41,91 +41,6 @@
 
 using namespace DiffservUtil;
 
-#ifdef WITH_IPv4
-bool MultiFieldClassifier::Filter::matches(IPv4Datagram *datagram)
-{
-    if (srcPrefixLength > 0 && (srcAddr.isIPv6() || !datagram->getSrcAddress().prefixMatches(srcAddr.get4(), srcPrefixLength)))
-        return false;
-    if (destPrefixLength > 0 && (destAddr.isIPv6() || !datagram->getDestAddress().prefixMatches(destAddr.get4(), destPrefixLength)))
-        return false;
-    if (protocol >= 0 && datagram->getTransportProtocol() != protocol)
-        return false;
-    if (tosMask != 0 && (tos & tosMask) != (datagram->getTypeOfService() & tosMask))
-        return false;
-    if (srcPortMin >= 0 || destPortMin >= 0)
-    {
-        int srcPort = -1, destPort = -1;
-        cPacket *packet = datagram->getEncapsulatedPacket();
-#ifdef WITH_UDP
-        UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(packet);
-        if (udpPacket)
-        {
-            srcPort = udpPacket->getSourcePort();
-            destPort = udpPacket->getDestinationPort();
-        }
-#endif
-#ifdef WITH_TCP_COMMON
-        TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(packet);
-        if (tcpSegment)
-        {
-            srcPort = tcpSegment->getSrcPort();
-            destPort = tcpSegment->getDestPort();
-        }
-#endif
-
-        if (srcPortMin >= 0 && (srcPort < srcPortMin || srcPort > srcPortMax))
-            return false;
-        if (destPortMin >= 0 && (destPort < destPortMin || destPort > destPortMax))
-            return false;
-    }
-
-    return true;
-}
-#endif
-
-#ifdef WITH_IPv6
-bool MultiFieldClassifier::Filter::matches(IPv6Datagram *datagram)
-{
-    if (srcPrefixLength > 0 && (!srcAddr.isIPv6() || !datagram->getSrcAddress().matches(srcAddr.get6(), srcPrefixLength)))
-        return false;
-    if (destPrefixLength > 0 && (!destAddr.isIPv6() || !datagram->getDestAddress().matches(destAddr.get6(), destPrefixLength)))
-        return false;
-    if (protocol >= 0 && datagram->getTransportProtocol() != protocol)
-        return false;
-    if (tosMask != 0 && (tos & tosMask) != (datagram->getTrafficClass() & tosMask))
-        return false;
-    if (srcPortMin >= 0 || destPortMin >= 0)
-    {
-        int srcPort = -1, destPort = -1;
-        cPacket *packet = datagram->getEncapsulatedPacket();
-#ifdef WITH_UDP
-        UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(packet);
-        if (udpPacket)
-        {
-            srcPort = udpPacket->getSourcePort();
-            destPort = udpPacket->getDestinationPort();
-        }
-#endif
-#ifdef WITH_TCP_COMMON
-        TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(packet);
-        if (tcpSegment)
-        {
-            srcPort = tcpSegment->getSrcPort();
-            destPort = tcpSegment->getDestPort();
-        }
-#endif
-
-        if (srcPortMin >= 0 && (srcPort < srcPortMin || srcPort > srcPortMax))
-            return false;
-        if (destPortMin >= 0 && (destPort < destPortMin || destPort > destPortMax))
-            return false;
-    }
-
-    return true;
-}
-#endif
-
-
 Define_Module(MultiFieldClassifier);
 
 simsignal_t MultiFieldClassifier::pkClassSignal = registerSignal("pkClass");
@@ -171,32 +86,67 @@ void MultiFieldClassifier::handleMessage(cMessage *msg)
 }
 
 int MultiFieldClassifier::classifyPacket(cPacket *packet)
+{
+    Filter::Fields fields;
+    if (!getFields(packet, fields))
+        return -1;
+    const Filter *filter = filters.findFirstMatch(fields);
+    return filter ? filter->gateIndex : -1;
+}
+
+bool MultiFieldClassifier::getFields(cPacket *packet, Filter::Fields& fields)
 {
     for (; packet; packet = packet->getEncapsulatedPacket())
     {
+        bool found = false;
 #ifdef WITH_IPv4
         IPv4Datagram *ipv4Datagram = dynamic_cast<IPv4Datagram*>(packet);
         if (ipv4Datagram)
         {
-            for (std::vector<Filter>::iterator it = filters.begin(); it != filters.end(); ++it)
-                if (it->matches(ipv4Datagram))
-                    return it->gateIndex;
-            return -1;
+            fields.isIPv6 = false;
+            fields.srcAddr = ipv4Datagram->getSrcAddress();
+            fields.destAddr = ipv4Datagram->getDestAddress();
+            fields.protocol = ipv4Datagram->getTransportProtocol();
+            fields.tos = ipv4Datagram->getTypeOfService();
+            found = true;
         }
 #endif
 #ifdef WITH_IPv6
-        IPv6Datagram *ipv6Datagram = dynamic_cast<IPv6Datagram *>(packet);
+        IPv6Datagram *ipv6Datagram = found ? NULL : dynamic_cast<IPv6Datagram *>(packet);
         if (ipv6Datagram)
         {
-            for (std::vector<Filter>::iterator it = filters.begin(); it != filters.end(); ++it)
-                if (it->matches(ipv6Datagram))
-                    return it->gateIndex;
-            return -1;
+            fields.isIPv6 = true;
+            fields.srcAddr = ipv6Datagram->getSrcAddress();
+            fields.destAddr = ipv6Datagram->getDestAddress();
+            fields.protocol = ipv6Datagram->getTransportProtocol();
+            fields.tos = ipv6Datagram->getTrafficClass();
+            found = true;
         }
 #endif
+        if (found)
+        {
+            cPacket *transportPacket = packet->getEncapsulatedPacket();
+#ifdef WITH_UDP
+            UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(transportPacket);
+            if (udpPacket)
+            {
+                fields.srcPort = udpPacket->getSourcePort();
+                fields.destPort = udpPacket->getDestinationPort();
+            }
+#endif
+#ifdef WITH_TCP_COMMON
+            TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(transportPacket);
+            if (tcpSegment)
+            {
+                fields.srcPort = tcpSegment->getSrcPort();
+                fields.destPort = tcpSegment->getDestPort();
+            }
+#endif
+            return true;
+        }
     }
 
-    return -1;
+    return false;
 }
 
 void MultiFieldClassifier::addFilter(const Filter &filter)
@@ -228,7 +178,7 @@ void MultiFieldClassifier::addFilter(const Filter &filter)
     if (filter.destPortMin != -1 && filter.destPortMin > filter.destPortMax)
         throw cRuntimeError("destPortMin > destPortMax");
 
-    filters.push_back(filter);
+    filters.addFilter(filter);
 }
 
 void MultiFieldClassifier::configureFilters(cXMLElement *config)
@@ -22,42 +22,19 @@
 
 #include "INETDefs.h"
 
+#include "MultiFieldFilterIndex.h"
+
 /**
  * Absolute dropper.
  */
 class INET_API MultiFieldClassifier : public cSimpleModule
 {
   protected:
-        struct Filter
-        {
-            int gateIndex;
-
-            IPvXAddress srcAddr;
-            int srcPrefixLength;
-            IPvXAddress destAddr;
-            int destPrefixLength;
-            int protocol;
-            int tos;
-            int tosMask;
-            int srcPortMin;
-            int srcPortMax;
-            int destPortMin;
-            int destPortMax;
-
-            Filter() : gateIndex(-1),
-                       srcPrefixLength(0), destPrefixLength(0), protocol(-1), tos(0), tosMask(0),
-                       srcPortMin(-1), srcPortMax(-1), destPortMin(-1), destPortMax(-1)  {}
-    #ifdef WITH_IPv4
-            bool matches(IPv4Datagram *datagram);
-    #endif
-    #ifdef WITH_IPv6
-            bool matches(IPv6Datagram *datagram);
-    #endif
-        };
+    typedef MultiFieldFilter Filter;
 
   protected:
     int numOutGates;
-    std::vector<Filter> filters;
+    MultiFieldFilterIndex filters;
 
     int numRcvd;
 
@@ -67,6 +44,9 @@ class INET_API MultiFieldClassifier : public cSimpleModule
     void addFilter(const Filter &filter);
     void configureFilters(cXMLElement *config);
 
+    /** Extracts the fields filters look at from the first IP datagram in the packet; returns false if there's none */
+    virtual bool getFields(cPacket *packet, Filter::Fields& fields);
+
   public:
     MultiFieldClassifier() {}
 
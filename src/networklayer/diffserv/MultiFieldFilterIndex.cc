@@ -0,0 +1,175 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "MultiFieldFilterIndex.h"
+
+
+bool MultiFieldFilter::matches(const Fields& fields) const
+{
+    if (srcPrefixLength > 0)
+    {
+        if (srcAddr.isIPv6() != fields.isIPv6)
+            return false;
+        if (fields.isIPv6 ? !fields.srcAddr.get6().matches(srcAddr.get6(), srcPrefixLength)
+                             : !fields.srcAddr.get4().prefixMatches(srcAddr.get4(), srcPrefixLength))
+            return false;
+    }
+    if (destPrefixLength > 0)
+    {
+        if (destAddr.isIPv6() != fields.isIPv6)
+            return false;
+        if (fields.isIPv6 ? !fields.destAddr.get6().matches(destAddr.get6(), destPrefixLength)
+                              : !fields.destAddr.get4().prefixMatches(destAddr.get4(), destPrefixLength))
+            return false;
+    }
+    if (protocol >= 0 && fields.protocol != protocol)
+        return false;
+    if (tosMask != 0 && (tos & tosMask) != (fields.tos & tosMask))
+        return false;
+    if (srcPortMin >= 0 && (fields.srcPort < srcPortMin || fields.srcPort > srcPortMax))
+        return false;
+    if (destPortMin >= 0 && (fields.destPort < destPortMin || fields.destPort > destPortMax))
+        return false;
+    return true;
+}
+
+void MultiFieldFilterIndex::makeMask(int family, int prefixLength, uint32 *mask)
+{
+    int numWords = family == 6 ? 4 : 1;
+    for (int i = 0; i < 4; i++)
+    {
+        int bits = i < numWords ? std::max(0, std::min(32, prefixLength - 32 * i)) : 0;
+        mask[i] = bits == 0 ? 0 : (0xffffffffu << (32 - bits));
+    }
+}
+
+// the words of an address of the given family; the unused words are zero
+static void getWords(const IPvXAddress& address, bool isIPv6, uint32 *words)
+{
+    if (isIPv6)
+    {
+        IPv6Address address6 = address.get6();
+        const uint32 *w = address6.words();
+        for (int i = 0; i < 4; i++)
+            words[i] = w[i];
+    }
+    else
+    {
+        words[0] = address.get4().getInt();
+        words[1] = words[2] = words[3] = 0;
+    }
+}
+
+void MultiFieldFilterIndex::makeKey(const Tuple& tuple, const IPvXAddress& srcAddr, const IPvXAddress& destAddr, Key& key)
+{
+    if (tuple.family == 0)
+    {
+        std::fill(key.words, key.words + KEY_WORDS, 0);
+        return;
+    }
+    getWords(srcAddr, tuple.family == 6, key.words);
+    getWords(destAddr, tuple.family == 6, key.words + 4);
+    for (int i = 0; i < KEY_WORDS; i++)
+        key.words[i] &= tuple.mask[i];
+}
+
+uint32 MultiFieldFilterIndex::KeyHash::operator()(const Key& key) const
+{
+    // multiplicative hashing, as in InterfaceAddressIndex
+    uint32 h = 0;
+    for (int i = 0; i < KEY_WORDS; i++)
+        h = (h ^ key.words[i]) * 0x9e3779b1u;
+    return h ^ (h >> 16);
+}
+
+MultiFieldFilterIndex::Tuple& MultiFieldFilterIndex::getTuple(int family, int srcPrefixLength, int destPrefixLength)
+{
+    // a new tuple is always created for the last filter, so tuples stay ordered by firstFilterIndex
+    for (std::vector<Tuple>::iterator it = tuples.begin(); it != tuples.end(); ++it)
+        if (it->family == family && it->srcPrefixLength == srcPrefixLength && it->destPrefixLength == destPrefixLength)
+            return *it;
+
+    tuples.push_back(Tuple());
+    Tuple& tuple = tuples.back();
+    tuple.family = family;
+    tuple.srcPrefixLength = srcPrefixLength;
+    tuple.destPrefixLength = destPrefixLength;
+    tuple.firstFilterIndex = filters.size() - 1;
+    makeMask(family, srcPrefixLength, tuple.mask);
+    makeMask(family, destPrefixLength, tuple.mask + 4);
+    return tuple;
+}
+
+void MultiFieldFilterIndex::addFilter(const MultiFieldFilter& filter)
+{
+    int index = filters.size();
+    filters.push_back(filter);
+
+    // the address family the filter applies to
+    int srcFamily = filter.srcPrefixLength > 0 ? (filter.srcAddr.isIPv6() ? 6 : 4) : 0;
+    int destFamily = filter.destPrefixLength > 0 ? (filter.destAddr.isIPv6() ? 6 : 4) : 0;
+    if (srcFamily != 0 && destFamily != 0 && srcFamily != destFamily)
+        return; // never matches
+    int family = srcFamily != 0 ? srcFamily : destFamily;
+
+    // longer prefixes than the address are the same as the full address, see IPv4Address::prefixMatches()
+    int maxPrefixLength = family == 6 ? 128 : 32;
+    int srcPrefixLength = std::min(filter.srcPrefixLength, maxPrefixLength);
+    int destPrefixLength = std::min(filter.destPrefixLength, maxPrefixLength);
+
+    Tuple& tuple = getTuple(family, srcPrefixLength, destPrefixLength);
+
+    Key key;
+    makeKey(tuple, filter.srcAddr, filter.destAddr, key);
+    const int *filterList = tuple.filterListIndices.find(key);
+    if (filterList)
+        tuple.filterLists[*filterList].push_back(index);
+    else
+    {
+        tuple.filterListIndices.insert(key, tuple.filterLists.size());
+        tuple.filterLists.push_back(std::vector<int>(1, index));
+    }
+}
+
+const MultiFieldFilter *MultiFieldFilterIndex::findFirstMatch(const MultiFieldFilter::Fields& fields) const
+{
+    int family = fields.isIPv6 ? 6 : 4;
+    int bestIndex = filters.size();
+    Key key;
+    for (std::vector<Tuple>::const_iterator tuple = tuples.begin(); tuple != tuples.end() && tuple->firstFilterIndex < bestIndex; ++tuple)
+    {
+        if (tuple->family != 0 && tuple->family != family)
+            continue;
+        makeKey(*tuple, fields.srcAddr, fields.destAddr, key);
+        const int *filterList = tuple->filterListIndices.find(key);
+        if (!filterList)
+            continue;
+
+        // the candidates are in ascending order: the first one matching
+        // the remaining fields wins, unless an earlier filter already did
+        const std::vector<int>& candidates = tuple->filterLists[*filterList];
+        for (std::vector<int>::const_iterator i = candidates.begin(); i != candidates.end() && *i < bestIndex; ++i)
+        {
+            if (filters[*i].matches(fields))
+            {
+                bestIndex = *i;
+                break;
+            }
+        }
+    }
+    return bestIndex < (int)filters.size() ? &filters[bestIndex] : NULL;
+}
@@ -0,0 +1,135 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MULTIFIELDFILTERINDEX_H
+#define __INET_MULTIFIELDFILTERINDEX_H
+
+#include <algorithm>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPvXAddress.h"
+#include "OpenAddressingTable.h"
+
+
+/**
+ * A filter of MultiFieldClassifier. Fields that are not set (zero prefix
+ * length or mask, -1 protocol or port) match anything.
+ */
+struct INET_API MultiFieldFilter
+{
+    /**
+     * The header fields of a datagram that filters look at. Ports are -1
+     * if the datagram does not carry an UDP or TCP packet; tos is the
+     * traffic class for IPv6.
+     */
+    struct Fields
+    {
+        bool isIPv6;            // IPvXAddress represents the unspecified IPv6 address as IPv4
+        IPvXAddress srcAddr;
+        IPvXAddress destAddr;
+        int protocol;
+        int tos;
+        int srcPort;
+        int destPort;
+
+        Fields() : isIPv6(false), protocol(-1), tos(0), srcPort(-1), destPort(-1) {}
+    };
+
+    int gateIndex;
+
+    IPvXAddress srcAddr;
+    int srcPrefixLength;
+    IPvXAddress destAddr;
+    int destPrefixLength;
+    int protocol;
+    int tos;
+    int tosMask;
+    int srcPortMin;
+    int srcPortMax;
+    int destPortMin;
+    int destPortMax;
+
+    MultiFieldFilter() : gateIndex(-1),
+                         srcPrefixLength(0), destPrefixLength(0), protocol(-1), tos(0), tosMask(0),
+                         srcPortMin(-1), srcPortMax(-1), destPortMin(-1), destPortMax(-1)  {}
+
+    bool matches(const Fields& fields) const;
+};
+
+/**
+ * Finds the first matching filter of an ordered filter list in sub-linear
+ * time, using tuple space search. Filters are grouped by the
+ * (address family, source prefix length, destination prefix length) tuple;
+ * within a tuple, a hash table keyed by the masked address pair gives the
+ * few filters that may match. A lookup probes each tuple at most once, so
+ * its cost depends on the number of distinct prefix length combinations
+ * and not on the number of filters.
+ *
+ * Filters can only be added; the result is always the same as testing every
+ * filter in the order of addition.
+ */
+class INET_API MultiFieldFilterIndex
+{
+  protected:
+    enum { KEY_WORDS = 8 };
+
+    struct Key
+    {
+        uint32 words[KEY_WORDS];    // masked source and destination address words
+        Key() { std::fill(words, words + KEY_WORDS, 0); }
+        bool operator==(const Key& other) const { return std::equal(words, words + KEY_WORDS, other.words); }
+    };
+
+    struct KeyHash
+    {
+        uint32 operator()(const Key& key) const;
+    };
+
+    struct Tuple
+    {
+        int family;             // 4 or 6; 0 if the filters do not check addresses
+        int srcPrefixLength;
+        int destPrefixLength;
+        int firstFilterIndex;   // the smallest filter index in the tuple
+        uint32 mask[KEY_WORDS];
+        OpenAddressingTable<Key, int, KeyHash> filterListIndices;  // values are indices into filterLists
+        std::vector<std::vector<int> > filterLists;  // filter indices in ascending order
+    };
+
+    std::vector<MultiFieldFilter> filters;
+    std::vector<Tuple> tuples;  // in ascending order of firstFilterIndex
+
+  protected:
+    static void makeMask(int family, int prefixLength, uint32 *mask);
+    static void makeKey(const Tuple& tuple, const IPvXAddress& srcAddr, const IPvXAddress& destAddr, Key& key);
+    Tuple& getTuple(int family, int srcPrefixLength, int destPrefixLength);
+
+  public:
+    /** Appends the filter; it matches only if none of the previously added ones does. */
+    void addFilter(const MultiFieldFilter& filter);
+
+    /** Returns the first filter matching the fields, or NULL. */
+    const MultiFieldFilter *findFirstMatch(const MultiFieldFilter::Fields& fields) const;
+
+    const std::vector<MultiFieldFilter>& getFilters() const { return filters; }
+
+    int getNumTuples() const { return tuples.size(); }
+};
+
+#endif
@@ -0,0 +1,199 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+
+#include "IPv4RouteTrie.h"
+
+#include "IPv4Route.h"
+
+
+IPv4RouteTrie::IPv4RouteTrie(RouteLessThan lessThan) : lessThan(lessThan), numRoutes(0)
+{
+    root = new Node(0, 0, NULL);
+}
+
+IPv4RouteTrie::~IPv4RouteTrie()
+{
+    deleteSubtree(root);
+}
+
+void IPv4RouteTrie::deleteSubtree(Node *node)
+{
+    if (node)
+    {
+        deleteSubtree(node->child[0]);
+        deleteSubtree(node->child[1]);
+        delete node;
+    }
+}
+
+void IPv4RouteTrie::clear()
+{
+    deleteSubtree(root->child[0]);
+    deleteSubtree(root->child[1]);
+    root->child[0] = root->child[1] = NULL;
+    root->routes.clear();
+    numRoutes = 0;
+}
+
+int IPv4RouteTrie::commonPrefixLength(uint32 a, uint32 b, int maxLength)
+{
+    uint32 diff = a ^ b;
+    int length = 0;
+    while (length < maxLength && (diff & 0x80000000u) == 0)
+    {
+        diff <<= 1;
+        length++;
+    }
+    return length;
+}
+
+void IPv4RouteTrie::addRoute(IPv4Route *route)
+{
+    int length = route->getNetmask().getNetmaskLength();
+    uint32 prefix = route->getDestination().getInt() & mask(length);
+
+    Node *node = root;
+    while (node->length != length)
+    {
+        int bit = bitAt(prefix, node->length);
+        Node *child = node->child[bit];
+        if (!child)
+        {
+            // new leaf
+            child = node->child[bit] = new Node(prefix, length, node);
+            node = child;
+            break;
+        }
+
+        int common = commonPrefixLength(child->prefix, prefix, std::min(child->length, length));
+        if (common == child->length)
+        {
+            // child's prefix covers ours: descend
+            node = child;
+            continue;
+        }
+
+        // split the edge between node and child
+        Node *inner;
+        if (common == length)
+        {
+            // our prefix lies on the edge: it becomes the parent of child
+            inner = new Node(prefix, length, node);
+        }
+        else
+        {
+            // the paths diverge: add a routeless branching node and a new leaf
+            inner = new Node(prefix & mask(common), common, node);
+            Node *leaf = new Node(prefix, length, inner);
+            inner->child[bitAt(prefix, common)] = leaf;
+        }
+        inner->child[bitAt(child->prefix, common)] = child;
+        child->parent = inner;
+        node->child[bit] = inner;
+        node = (common == length) ? inner : inner->child[bitAt(prefix, common)];
+        break;
+    }
+
+    std::vector<IPv4Route *>& routes = node->routes;
+    routes.insert(std::upper_bound(routes.begin(), routes.end(), route, lessThan), route);
+    numRoutes++;
+}
+
+IPv4RouteTrie::Node *IPv4RouteTrie::findNode(uint32 prefix, int length) const
+{
+    Node *node = root;
+    while (node && node->length < length)
+    {
+        node = node->child[bitAt(prefix, node->length)];
+        if (node && (node->length > length || ((node->prefix ^ prefix) & mask(node->length)) != 0))
+            return NULL;
+    }
+    return (node && node->length == length) ? node : NULL;
+}
+
+IPv4RouteTrie::Node *IPv4RouteTrie::findRouteNode(Node *node, IPv4Route *route) const
+{
+    if (!node)
+        return NULL;
+    if (std::find(node->routes.begin(), node->routes.end(), route) != node->routes.end())
+        return node;
+    Node *found = findRouteNode(node->child[0], route);
+    return found ? found : findRouteNode(node->child[1], route);
+}
+
+bool IPv4RouteTrie::removeFromNode(Node *node, IPv4Route *route)
+{
+    if (!node)
+        return false;
+    std::vector<IPv4Route *>::iterator it = std::find(node->routes.begin(), node->routes.end(), route);
+    if (it == node->routes.end())
+        return false;
+    node->routes.erase(it);
+    numRoutes--;
+    compact(node);
+    return true;
+}
+
+bool IPv4RouteTrie::removeRoute(IPv4Route *route)
+{
+    int length = route->getNetmask().isValidNetmask() ? route->getNetmask().getNetmaskLength() : -1;
+    if (length >= 0 && removeFromNode(findNode(route->getDestination().getInt() & mask(length), length), route))
+        return true;
+
+    // destination or netmask was changed while the route was in the table
+    return removeFromNode(findRouteNode(root, route), route);
+}
+
+void IPv4RouteTrie::compact(Node *node)
+{
+    // drop routeless nodes that have less than two children (except the root)
+    while (node != root && node->routes.empty() && !(node->child[0] && node->child[1]))
+    {
+        Node *parent = node->parent;
+        Node *child = node->child[0] ? node->child[0] : node->child[1];
+        int bit = parent->child[1] == node ? 1 : 0;
+        parent->child[bit] = child;
+        if (child)
+            child->parent = parent;
+        delete node;
+        node = parent;
+    }
+}
+
+IPv4Route *IPv4RouteTrie::lookup(const IPv4Address& dest) const
+{
+    uint32 addr = dest.getInt();
+    IPv4Route *bestRoute = NULL;
+    for (Node *node = root; node && ((node->prefix ^ addr) & mask(node->length)) == 0; )
+    {
+        // the first valid route of the deepest matching node wins
+        for (std::vector<IPv4Route *>::const_iterator it = node->routes.begin(); it != node->routes.end(); ++it)
+        {
+            if ((*it)->isValid())
+            {
+                bestRoute = *it;
+                break;
+            }
+        }
+        if (node->length == 32)
+            break;
+        node = node->child[bitAt(addr, node->length)];
+    }
+    return bestRoute;
+}
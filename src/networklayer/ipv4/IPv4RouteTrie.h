@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPv4ROUTETRIE_H
+#define __INET_IPv4ROUTETRIE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPv4Address.h"
+
+class IPv4Route;
+
+
+/**
+ * Path-compressed binary (Patricia) trie of IPv4 unicast routes, keyed by
+ * destination prefix. Used by RoutingTable for longest prefix matching.
+ *
+ * Each trie node stores the routes of exactly one prefix, in the same order
+ * as RoutingTable keeps them in its route vector (the comparator is supplied
+ * by the owner), so lookup() returns the same route as a linear scan
+ * of the sorted route vector would: the first valid route of the longest
+ * matching prefix. Insertion, removal and lookup cost O(32) node visits,
+ * independent of the number of routes.
+ */
+class INET_API IPv4RouteTrie
+{
+  public:
+    typedef bool (*RouteLessThan)(const IPv4Route *a, const IPv4Route *b);
+
+  protected:
+    struct Node
+    {
+        uint32 prefix;          // destination, bits beyond 'length' are zero
+        int length;             // prefix length, 0..32
+        Node *parent;
+        Node *child[2];
+        std::vector<IPv4Route *> routes;  // routes for exactly this prefix, best first
+
+        Node(uint32 prefix, int length, Node *parent) : prefix(prefix), length(length), parent(parent) { child[0] = child[1] = NULL; }
+    };
+
+    RouteLessThan lessThan;
+    Node *root;     // the 0.0.0.0/0 node, always present
+    int numRoutes;
+
+  protected:
+    static uint32 mask(int length) { return length == 0 ? 0 : (0xffffffffu << (32 - length)); }
+    static int bitAt(uint32 addr, int pos) { return (addr >> (31 - pos)) & 1; }
+    static int commonPrefixLength(uint32 a, uint32 b, int maxLength);
+
+    Node *findNode(uint32 prefix, int length) const;
+    bool removeFromNode(Node *node, IPv4Route *route);
+    void compact(Node *node);
+    Node *findRouteNode(Node *node, IPv4Route *route) const;
+    void deleteSubtree(Node *node);
+
+  private:
+    // not copyable
+    IPv4RouteTrie(const IPv4RouteTrie&);
+    IPv4RouteTrie& operator=(const IPv4RouteTrie&);
+
+  public:
+    IPv4RouteTrie(RouteLessThan lessThan);
+    ~IPv4RouteTrie();
+
+    /** Adds the route under its current destination/netmask. Equal routes keep insertion order. */
+    void addRoute(IPv4Route *route);
+
+    /**
+     * Removes the route. The route is first looked for under its current
+     * destination/netmask; if those were modified since insertion, the
+     * whole trie is searched. Returns false if the route was not found.
+     */
+    bool removeRoute(IPv4Route *route);
+
+    /** Returns the first valid route of the longest prefix matching dest, or NULL. */
+    IPv4Route *lookup(const IPv4Address& dest) const;
+
+    /** Removes all routes (the routes themselves are not deleted). */
+    void clear();
+
+    int getNumRoutes() const { return numRoutes; }
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "InterfaceTableAccess.h"
 #include "IPv4InterfaceData.h"
 #include "IPv4Route.h"
+#include "IPv4RouteTrie.h"
 #include "NotificationBoard.h"
 #include "NotifierConsts.h"
 #include "RoutingTableParser.h"
@@ -56,6 +57,7 @@ RoutingTable::RoutingTable()
 {
     ift = NULL;
     nb = NULL;
+    routeTrie = NULL;
 }
 
 RoutingTable::~RoutingTable()
@@ -64,6 +66,7 @@ RoutingTable::~RoutingTable()
         delete routes[i];
     for (unsigned int i=0; i<multicastRoutes.size(); i++)
         delete multicastRoutes[i];
+    delete routeTrie;
 }
 
 void RoutingTable::initialize(int stage)
@@ -78,6 +81,16 @@ void RoutingTable::initialize(int stage)
         IPForward = par("IPForward").boolValue();
         multicastForward = par("forwardMulticast");
 
+        const char *routeLookup = par("routeLookup");
+        if (!strcmp(routeLookup, "trie"))
+        {
+            routeTrie = new IPv4RouteTrie(routeLessThan);
+            for (unsigned int i=0; i<routes.size(); i++)
+                routeTrie->addRoute(routes[i]);
+        }
+        else if (strcmp(routeLookup, "linear"))
+            error("Invalid routeLookup parameter: '%s'", routeLookup);
+
         nb->subscribe(this, NF_INTERFACE_CREATED);
         nb->subscribe(this, NF_INTERFACE_DELETED);
         nb->subscribe(this, NF_INTERFACE_STATE_CHANGED);
@@ -233,6 +246,8 @@ void RoutingTable::deleteInterfaceRoutes(InterfaceEntry *entry)
         if (route->getInterface() == entry)
         {
             it = routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -278,7 +293,6 @@ void RoutingTable::deleteInterfaceRoutes(InterfaceEntry *entry)
 void RoutingTable::invalidateCache()
 {
     routingCache.clear();
-    localAddresses.clear();
     localBroadcastAddresses.clear();
 }
 
@@ -359,15 +373,7 @@ InterfaceEntry *RoutingTable::getInterfaceByAddress(const IPv4Address& addr) con
 {
     Enter_Method("getInterfaceByAddress(%u.%u.%u.%u)", addr.getDByte(0), addr.getDByte(1), addr.getDByte(2), addr.getDByte(3)); // note: str().c_str() too slow here
 
-    if (addr.isUnspecified())
-        return NULL;
-    for (int i=0; i<ift->getNumInterfaces(); ++i)
-    {
-        InterfaceEntry *ie = ift->getInterface(i);
-        if (ie->ipv4Data()->getIPAddress()==addr)
-            return ie;
-    }
-    return NULL;
+    return ift->findInterfaceByAddress(addr);
 }
 
 
@@ -391,18 +397,16 @@ bool RoutingTable::isLocalAddress(const IPv4Address& dest) const
 {
     Enter_Method("isLocalAddress(%u.%u.%u.%u)", dest.getDByte(0), dest.getDByte(1), dest.getDByte(2), dest.getDByte(3)); // note: str().c_str() too slow here
 
-    if (localAddresses.empty())
+    if (dest.isUnspecified())
     {
-        // collect interface addresses if not yet done
+        // the interface table does not index unspecified addresses
         for (int i=0; i<ift->getNumInterfaces(); i++)
-        {
-            IPv4Address interfaceAddr = ift->getInterface(i)->ipv4Data()->getIPAddress();
-            localAddresses.insert(interfaceAddr);
-        }
+            if (ift->getInterface(i)->ipv4Data()->getIPAddress().isUnspecified())
+                return true;
+        return false;
     }
 
-    AddressSet::iterator it = localAddresses.find(dest);
-    return it!=localAddresses.end();
+    return ift->findInterfaceByAddress(dest) != NULL;
 }
 
 // JcM add: check if the dest addr is local network broadcast
@@ -467,6 +471,8 @@ void RoutingTable::purge()
         else
         {
             it = routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -501,6 +507,10 @@ IPv4Route *RoutingTable::findBestMatchingRoute(const IPv4Address& dest) const
 {
     Enter_Method("findBestMatchingRoute(%u.%u.%u.%u)", dest.getDByte(0), dest.getDByte(1), dest.getDByte(2), dest.getDByte(3)); // note: str().c_str() too slow here
 
+    // the trie needs no caching: a lookup visits at most 33 nodes
+    if (routeTrie)
+        return routeTrie->lookup(dest);
+
     RoutingCache::iterator it = routingCache.find(dest);
     if (it != routingCache.end())
     {
@@ -644,6 +654,8 @@ void RoutingTable::internalAddRoute(IPv4Route *entry)
     // stop at the first match when doing the longest netmask matching
     RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), entry, routeLessThan);
     routes.insert(pos, entry);
+    if (routeTrie)
+        routeTrie->addRoute(entry);
 
     entry->setRoutingTable(this);
 }
@@ -666,6 +678,8 @@ IPv4Route *RoutingTable::internalRemoveRoute(IPv4Route *entry)
     if (i!=routes.end())
     {
         routes.erase(i);
+        if (routeTrie)
+            routeTrie->removeRoute(entry);
         return entry;
     }
     return NULL;
@@ -858,6 +872,8 @@ void RoutingTable::updateNetmaskRoutes()
             std::vector<IPv4Route *>::iterator it = routes.begin()+(k--);  // '--' is necessary because indices shift down
             IPv4Route *route = *it;
             routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -884,6 +900,8 @@ void RoutingTable::updateNetmaskRoutes()
             route->setRoutingTable(this);
             RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), route, routeLessThan);
             routes.insert(pos, route);
+            if (routeTrie)
+                routeTrie->addRoute(route);
             nb->fireChangeNotification(NF_IPv4_ROUTE_ADDED, route);
         }
     }
@@ -38,6 +38,7 @@
 #include "ILifecycle.h"
 
 class IInterfaceTable;
+class IPv4RouteTrie;
 class NotificationBoard;
 class RoutingTableParser;
 
@@ -90,9 +91,9 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     typedef std::map<IPv4Address, IPv4Route *> RoutingCache;
     mutable RoutingCache routingCache;
 
-    // local addresses cache (to speed up isLocalAddress())
+    // local broadcast addresses cache (to speed up isLocalBroadcastAddress());
+    // local addresses are looked up in the address index of the interface table
     typedef std::set<IPv4Address> AddressSet;
-    mutable AddressSet localAddresses;
     // JcM add: to handle the local broadcast address
     mutable AddressSet localBroadcastAddresses;
 
@@ -103,6 +104,7 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
 
     typedef std::vector<IPv4Route *> RouteVector;
     RouteVector routes;          // Unicast route array, sorted by netmask desc, dest asc, metric asc
+    IPv4RouteTrie *routeTrie;    // Unicast routes indexed by destination prefix; NULL if linear lookup is used
 
     typedef std::vector<IPv4MulticastRoute*> MulticastRouteVector;
     MulticastRouteVector multicastRoutes; // Multicast route array, sorted by netmask desc, origin asc, metric asc
@@ -487,12 +487,8 @@ bool RoutingTable6::isLocalAddress(const IPv6Address& dest) const
     Enter_Method("isLocalAddress(%s) y/n", dest.str().c_str());
 
     // first, check if we have an interface with this address
-    for (int i=0; i<ift->getNumInterfaces(); i++)
-    {
-        InterfaceEntry *ie = ift->getInterface(i);
-        if (ie->ipv6Data()->hasAddress(dest))
-            return true;
-    }
+    if (ift->findInterfaceByAddress(dest))
+        return true;
 
     // then check for special, preassigned multicast addresses
     // (these addresses occur more rarely than specific interface addresses,
@@ -37,10 +37,14 @@
 #include "ICMPv6Message_m.h"
 #endif
 
+#include "TCPByteStreamIntervalRcvQueue.h"
 #include "TCPByteStreamRcvQueue.h"
 #include "TCPByteStreamSendQueue.h"
+#include "TCPChunkedByteStreamSendQueue.h"
+#include "TCPMsgBasedIntervalRcvQueue.h"
 #include "TCPMsgBasedRcvQueue.h"
 #include "TCPMsgBasedSendQueue.h"
+#include "TCPVirtualDataIntervalRcvQueue.h"
 #include "TCPVirtualDataRcvQueue.h"
 #include "TCPVirtualDataSendQueue.h"
 
@@ -97,6 +101,8 @@ void TCP::initialize(int stage)
         WATCH_PTRMAP(tcpAppConnMap);
 
         recordStatistics = par("recordStats");
+        intervalRcvQueues = par("intervalRcvQueues");
+        chunkedSendQueues = par("chunkedSendQueues");
 
         cModule *netw = simulation.getSystemModule();
         testing = netw->hasPar("testing") && netw->par("testing").boolValue();
@@ -302,45 +308,9 @@ void TCP::updateDisplayString()
 
 TCPConnection *TCP::findConnForSegment(TCPSegment *tcpseg, IPvXAddress srcAddr, IPvXAddress destAddr)
 {
-    SockPair key;
-    key.localAddr = destAddr;
-    key.remoteAddr = srcAddr;
-    key.localPort = tcpseg->getDestPort();
-    key.remotePort = tcpseg->getSrcPort();
-    SockPair save = key;
-
-    // try with fully qualified SockPair
-    TcpConnMap::iterator i;
-    i = tcpConnMap.find(key);
-
-    if (i != tcpConnMap.end())
-        return i->second;
-
-    // try with localAddr missing (only localPort specified in passive/active open)
-    key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
-
-    if (i != tcpConnMap.end())
-        return i->second;
-
-    // try fully qualified local socket + blank remote socket (for incoming SYN)
-    key = save;
-    key.remoteAddr = IPvXAddress();
-    key.remotePort = -1;
-    i = tcpConnMap.find(key);
-
-    if (i != tcpConnMap.end())
-        return i->second;
-
-    // try with blank remote socket, and localAddr missing (for incoming SYN)
-    key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
-
-    if (i != tcpConnMap.end())
-        return i->second;
-
-    // given up
-    return NULL;
+    // same lookup sequence as on tcpConnMap: fully qualified socket pair,
+    // localAddr missing, then listening sockets (for incoming SYN)
+    return demuxTable.findConnection(destAddr, srcAddr, tcpseg->getDestPort(), tcpseg->getSrcPort());
 }
 
 TCPConnection *TCP::findConnForApp(int appGateIndex, int connId)
@@ -399,6 +369,7 @@ void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress re
 
     // then insert it into tcpConnMap
     tcpConnMap[key] = conn;
+    demuxTable.insert(localAddr, remoteAddr, localPort, remotePort, conn);
 
     // mark port as used
     if (localPort >= EPHEMERAL_PORTRANGE_START && localPort < EPHEMERAL_PORTRANGE_END)
@@ -419,6 +390,7 @@ void TCP::updateSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress
 
     // ...and remove from the old place in tcpConnMap
     tcpConnMap.erase(it);
+    demuxTable.remove(key.localAddr, key.remoteAddr, key.localPort, key.remotePort);
 
     // then update addresses/ports, and re-insert it with new key into tcpConnMap
     key.localAddr = conn->localAddr = localAddr;
@@ -426,6 +398,7 @@ void TCP::updateSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress
     ASSERT(conn->localPort == localPort);
     key.remotePort = conn->remotePort = remotePort;
     tcpConnMap[key] = conn;
+    demuxTable.insert(key.localAddr, key.remoteAddr, key.localPort, key.remotePort, conn);
 
     // localPort doesn't change (see ASSERT above), so there's no need to update usedEphemeralPorts[].
 }
@@ -465,6 +438,7 @@ void TCP::removeConnection(TCPConnection *conn)
     key2.localPort = conn->localPort;
     key2.remotePort = conn->remotePort;
     tcpConnMap.erase(key2);
+    demuxTable.remove(key2.localAddr, key2.remoteAddr, key2.localPort, key2.remotePort);
 
     // IMPORTANT: usedEphemeralPorts.erase(conn->localPort) is NOT GOOD because it
     // deletes ALL occurrences of the port from the multiset.
@@ -487,13 +461,27 @@ TCPSendQueue* TCP::createSendQueue(TCPDataTransferMode transferModeP)
     {
         case TCP_TRANSFER_BYTECOUNT:   return new TCPVirtualDataSendQueue();
         case TCP_TRANSFER_OBJECT:      return new TCPMsgBasedSendQueue();
-        case TCP_TRANSFER_BYTESTREAM:  return new TCPByteStreamSendQueue();
+        case TCP_TRANSFER_BYTESTREAM:
+            if (chunkedSendQueues)
+                return new TCPChunkedByteStreamSendQueue();
+            return new TCPByteStreamSendQueue();
         default: throw cRuntimeError("Invalid TCP data transfer mode: %d", transferModeP);
     }
 }
 
 TCPReceiveQueue* TCP::createReceiveQueue(TCPDataTransferMode transferModeP)
 {
+    if (intervalRcvQueues)
+    {
+        switch (transferModeP)
+        {
+            case TCP_TRANSFER_BYTECOUNT:   return new TCPVirtualDataIntervalRcvQueue();
+            case TCP_TRANSFER_OBJECT:      return new TCPMsgBasedIntervalRcvQueue();
+            case TCP_TRANSFER_BYTESTREAM:  return new TCPByteStreamIntervalRcvQueue();
+            default: throw cRuntimeError("Invalid TCP data transfer mode: %d", transferModeP);
+        }
+    }
+
     switch (transferModeP)
     {
         case TCP_TRANSFER_BYTECOUNT:   return new TCPVirtualDataRcvQueue();
@@ -547,6 +535,7 @@ void TCP::reset()
         delete it->second;
     tcpAppConnMap.clear();
     tcpConnMap.clear();
+    demuxTable.clear();
     usedEphemeralPorts.clear();
     lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
 }
@@ -27,6 +27,7 @@
 #include "ILifecycle.h"
 #include "IPvXAddress.h"
 #include "TCPCommand_m.h"
+#include "TCPDemuxTable.h"
 
 // Forward declarations:
 class TCPConnection;
@@ -143,6 +144,7 @@ class INET_API TCP : public cSimpleModule, public ILifecycle
 
     TcpAppConnMap tcpAppConnMap;
     TcpConnMap tcpConnMap;
+    TCPDemuxTable demuxTable;    // same socket pairs as tcpConnMap, hashed for findConnForSegment()
 
     ushort lastEphemeralPort;
     std::multiset<ushort> usedEphemeralPorts;
@@ -163,6 +165,8 @@ class INET_API TCP : public cSimpleModule, public ILifecycle
     static bool logverbose; // if !testing, turns on more verbose logging
 
     bool recordStatistics;  // output vectors on/off
+    bool intervalRcvQueues; // create TCP*IntervalRcvQueue receive queues
+    bool chunkedSendQueues; // create TCPChunkedByteStreamSendQueue for TCP_TRANSFER_BYTESTREAM
     bool isOperational;     // lifecycle: node is up/down
 
   public:
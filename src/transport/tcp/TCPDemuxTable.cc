@@ -0,0 +1,116 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "TCPDemuxTable.h"
+
+#define INITIAL_SIZE  64
+
+
+uint32 TCPDemuxTable::SocketPairHash::operator()(const SocketPair& socketPair) const
+{
+    // multiplicative hashing over the words of the 4-tuple
+    uint32 h = ((uint32)socketPair.localPort << 16) ^ (uint32)socketPair.remotePort;
+    const uint32 *w = socketPair.remoteAddr.words();
+    for (int i = 0; i < socketPair.remoteAddr.wordCount(); i++)
+        h = (h ^ w[i]) * 0x9e3779b1u;
+    w = socketPair.localAddr.words();
+    for (int i = 0; i < socketPair.localAddr.wordCount(); i++)
+        h = (h ^ w[i]) * 0x9e3779b1u;
+    h = (h ^ (socketPair.localAddr.isIPv6() ? 1 : 0)) * 0x9e3779b1u;
+    return h ^ (h >> 16);
+}
+
+TCPDemuxTable::TCPDemuxTable() : connections(INITIAL_SIZE)
+{
+}
+
+void TCPDemuxTable::clear()
+{
+    connections.clear();
+    listeners.clear();
+}
+
+void TCPDemuxTable::insert(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort, TCPConnection *conn)
+{
+    ASSERT(conn);
+
+    if (isListener(remoteAddr, remotePort))
+    {
+        listeners[localPort].push_back(Listener(localAddr, conn));
+        return;
+    }
+
+    SocketPair socketPair(localAddr, remoteAddr, localPort, remotePort);
+    ASSERT(!connections.find(socketPair));
+    connections.insert(socketPair, conn);
+}
+
+void TCPDemuxTable::remove(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort)
+{
+    if (isListener(remoteAddr, remotePort))
+    {
+        ListenerTable::iterator it = listeners.find(localPort);
+        if (it != listeners.end())
+        {
+            Listeners& list = it->second;
+            for (Listeners::iterator l = list.begin(); l != list.end(); ++l)
+            {
+                if (l->localAddr == localAddr)
+                {
+                    list.erase(l);
+                    break;
+                }
+            }
+            if (list.empty())
+                listeners.erase(it);
+        }
+        return;
+    }
+
+    connections.remove(SocketPair(localAddr, remoteAddr, localPort, remotePort));
+}
+
+TCPConnection *TCPDemuxTable::findConnection(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort) const
+{
+    // try with fully qualified socket pair
+    TCPConnection * const *conn = connections.find(SocketPair(localAddr, remoteAddr, localPort, remotePort));
+    if (conn)
+        return *conn;
+
+    // try with localAddr missing (only localPort specified in passive/active open)
+    if (!localAddr.isUnspecified())
+    {
+        conn = connections.find(SocketPair(IPvXAddress(), remoteAddr, localPort, remotePort));
+        if (conn)
+            return *conn;
+    }
+
+    // try listening sockets: fully qualified local socket first, then localAddr missing (for incoming SYN)
+    ListenerTable::const_iterator it = listeners.find(localPort);
+    if (it == listeners.end())
+        return NULL;
+
+    TCPConnection *wildcardListener = NULL;
+    for (Listeners::const_iterator l = it->second.begin(); l != it->second.end(); ++l)
+    {
+        if (l->localAddr == localAddr)
+            return l->conn;
+        if (l->localAddr.isUnspecified())
+            wildcardListener = l->conn;
+    }
+    return wildcardListener;
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TCPDEMUXTABLE_H
+#define __INET_TCPDEMUXTABLE_H
+
+#include <map>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPvXAddress.h"
+#include "OpenAddressingTable.h"
+
+class TCPConnection;
+
+
+/**
+ * Index used by TCP to find the connection an incoming segment belongs to.
+ *
+ * Socket pairs with a specified remote socket are stored in an
+ * OpenAddressingTable keyed by the 4-tuple, so demultiplexing a segment of
+ * an established connection costs a single probe sequence. Listening
+ * sockets (remote address unspecified and remote port -1) are kept in a
+ * separate table indexed by local port.
+ */
+class INET_API TCPDemuxTable
+{
+  protected:
+    struct SocketPair
+    {
+        IPvXAddress localAddr;
+        IPvXAddress remoteAddr;
+        int localPort;
+        int remotePort;
+        SocketPair() : localPort(-1), remotePort(-1) {}
+        SocketPair(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort) :
+            localAddr(localAddr), remoteAddr(remoteAddr), localPort(localPort), remotePort(remotePort) {}
+        bool operator==(const SocketPair& other) const {
+            return localPort == other.localPort && remotePort == other.remotePort && remoteAddr == other.remoteAddr && localAddr == other.localAddr;
+        }
+    };
+
+    struct SocketPairHash
+    {
+        uint32 operator()(const SocketPair& socketPair) const;
+    };
+
+    struct Listener
+    {
+        IPvXAddress localAddr;
+        TCPConnection *conn;
+        Listener(const IPvXAddress& localAddr, TCPConnection *conn) : localAddr(localAddr), conn(conn) {}
+    };
+    typedef std::vector<Listener> Listeners;
+    typedef std::map<int, Listeners> ListenerTable;  // key: local port
+
+    typedef OpenAddressingTable<SocketPair, TCPConnection *, SocketPairHash> ConnectionTable;
+
+    ConnectionTable connections;
+    ListenerTable listeners;
+
+  protected:
+    static bool isListener(const IPvXAddress& remoteAddr, int remotePort) { return remoteAddr.isUnspecified() && remotePort == -1; }
+
+  public:
+    TCPDemuxTable();
+
+    /** Removes all entries. */
+    void clear();
+
+    /** Adds the socket pair of conn; the socket pair must not be in the table yet. */
+    void insert(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort, TCPConnection *conn);
+
+    /** Removes the socket pair, if present. */
+    void remove(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort);
+
+    /**
+     * Returns the connection for a segment, or NULL. Tries the fully qualified
+     * socket pair, then the socket pair with unspecified local address, then the
+     * listening sockets (with matching, then with unspecified local address).
+     */
+    TCPConnection *findConnection(const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, int localPort, int remotePort) const;
+
+    int size() const { return connections.size(); }
+};
+
+#endif
@@ -19,25 +19,217 @@
 
 #include "TCPSACKRexmitQueue.h"
 
+// Define this to verify the whole tree after every modification of the queue.
+// checkQueue() walks all regions, which makes every operation O(n).
+//#define TCPSACKREXMITQUEUE_PARANOID
+
+#ifdef TCPSACKREXMITQUEUE_PARANOID
+#define CHECK_QUEUE()  ASSERT(checkQueue())
+#else
+#define CHECK_QUEUE()
+#endif
+
+TCPSACKRexmitQueue::Summary::Summary(const Region& region)
+{
+    empty = false;
+    sackedBytes = region.sacked ? region.endSeqNum - region.beginSeqNum : 0;
+    sackedRuns = region.sacked ? 1 : 0;
+    numRexmitted = region.rexmitted ? 1 : 0;
+    firstSacked = lastSacked = region.sacked;
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::Summary::operator+(const Summary& other) const
+{
+    if (empty)
+        return other;
+    if (other.empty)
+        return *this;
+
+    Summary sum;
+    sum.empty = false;
+    sum.sackedBytes = sackedBytes + other.sackedBytes;
+    // a run of sacked regions crossing the boundary is counted once
+    sum.sackedRuns = sackedRuns + other.sackedRuns - ((lastSacked && other.firstSacked) ? 1 : 0);
+    sum.numRexmitted = numRexmitted + other.numRexmitted;
+    sum.firstSacked = firstSacked;
+    sum.lastSacked = other.lastSacked;
+    return sum;
+}
 
 TCPSACKRexmitQueue::TCPSACKRexmitQueue()
 {
     conn = NULL;
+    root = NULL;
+    numRegions = 0;
+    randomState = 1;
     begin = end = 0;
 }
 
 TCPSACKRexmitQueue::~TCPSACKRexmitQueue()
 {
-    while (!rexmitQueue.empty())
-        rexmitQueue.pop_front();
+    deleteSubtree(root);
 }
 
 void TCPSACKRexmitQueue::init(uint32 seqNum)
 {
+    deleteSubtree(root);
+    root = NULL;
+    numRegions = 0;
     begin = seqNum;
     end = seqNum;
 }
 
+void TCPSACKRexmitQueue::updateSummary(Node *node)
+{
+    Summary summary(node->region);
+    if (node->left)
+        summary = node->left->summary + summary;
+    if (node->right)
+        summary = summary + node->right->summary;
+    node->summary = summary;
+}
+
+void TCPSACKRexmitQueue::deleteSubtree(Node *node)
+{
+    if (node)
+    {
+        deleteSubtree(node->left);
+        deleteSubtree(node->right);
+        delete node;
+    }
+}
+
+void TCPSACKRexmitQueue::split(Node *node, uint32 seqNum, Node *&left, Node *&right)
+{
+    // regions beginning before seqNum go to left, the others to right
+    if (!node)
+        left = right = NULL;
+    else if (seqLess(node->region.beginSeqNum, seqNum))
+    {
+        split(node->right, seqNum, node->right, right);
+        left = node;
+        updateSummary(node);
+    }
+    else
+    {
+        split(node->left, seqNum, left, node->left);
+        right = node;
+        updateSummary(node);
+    }
+}
+
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::insertNode(Node *node, Node *newNode)
+{
+    if (!node)
+        return newNode;
+
+    if (newNode->priority > node->priority)
+    {
+        split(node, newNode->region.beginSeqNum, newNode->left, newNode->right);
+        updateSummary(newNode);
+        return newNode;
+    }
+
+    if (seqLess(newNode->region.beginSeqNum, node->region.beginSeqNum))
+        node->left = insertNode(node->left, newNode);
+    else
+        node->right = insertNode(node->right, newNode);
+    updateSummary(node);
+    return node;
+}
+
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::removeFirstNode(Node *node, Node *&removed)
+{
+    if (!node->left)
+    {
+        removed = node;
+        return node->right;
+    }
+    node->left = removeFirstNode(node->left, removed);
+    updateSummary(node);
+    return node;
+}
+
+void TCPSACKRexmitQueue::refreshPath(Node *node, uint32 beginSeqNum)
+{
+    if (!node)
+        return;
+    if (seqLess(beginSeqNum, node->region.beginSeqNum))
+        refreshPath(node->left, beginSeqNum);
+    else if (beginSeqNum != node->region.beginSeqNum)
+        refreshPath(node->right, beginSeqNum);
+    updateSummary(node);
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::getSummaryFrom(Node *node, uint32 seqNum)
+{
+    // summary of the regions ending after seqNum
+    if (!node)
+        return Summary();
+    if (seqLE(node->region.endSeqNum, seqNum))
+        return getSummaryFrom(node->right, seqNum);
+    Summary summary = getSummaryFrom(node->left, seqNum) + Summary(node->region);
+    if (node->right)
+        summary = summary + node->right->summary;
+    return summary;
+}
+
+void TCPSACKRexmitQueue::resetBits(Node *node, bool sacked, bool rexmitted)
+{
+    if (node)
+    {
+        if (sacked)
+            node->region.sacked = false;
+        if (rexmitted)
+            node->region.rexmitted = false;
+        resetBits(node->left, sacked, rexmitted);
+        resetBits(node->right, sacked, rexmitted);
+        updateSummary(node);
+    }
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::findRegion(uint32 seqNum) const
+{
+    Node *node = root;
+    while (node)
+    {
+        if (seqLess(seqNum, node->region.beginSeqNum))
+            node = node->left;
+        else if (seqLE(node->region.endSeqNum, seqNum))
+            node = node->right;
+        else
+            return &node->region;
+    }
+    return NULL;
+}
+
+void TCPSACKRexmitQueue::insertRegion(const Region& region)
+{
+    Node *node = new Node();
+    node->region = region;
+    randomState = randomState * 1103515245 + 12345;
+    node->priority = randomState;
+    node->left = node->right = NULL;
+    updateSummary(node);
+    root = insertNode(root, node);
+    numRegions++;
+}
+
+void TCPSACKRexmitQueue::splitRegionAt(uint32 seqNum)
+{
+    Region *i = findRegion(seqNum);
+    ASSERT(i != NULL);
+
+    if (i->beginSeqNum != seqNum)
+    {
+        Region region = *i;
+        region.beginSeqNum = seqNum;
+        i->endSeqNum = seqNum;
+        regionChanged(i->beginSeqNum);
+        insertRegion(region);
+    }
+}
+
 std::string TCPSACKRexmitQueue::str() const
 {
     std::stringstream out;
@@ -46,43 +238,59 @@ std::string TCPSACKRexmitQueue::str() const
     return out.str();
 }
 
-void TCPSACKRexmitQueue::info() const
+void TCPSACKRexmitQueue::printRegions(Node *node, uint& j) const
 {
-    tcpEV << str() << endl;
-
-    uint j = 1;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
+    if (node)
     {
-        tcpEV << j << ". region: [" << i->beginSeqNum << ".." << i->endSeqNum
-              << ") \t sacked=" << i->sacked << "\t rexmitted=" << i->rexmitted
+        printRegions(node->left, j);
+        tcpEV << j << ". region: [" << node->region.beginSeqNum << ".." << node->region.endSeqNum
+              << ") \t sacked=" << node->region.sacked << "\t rexmitted=" << node->region.rexmitted
               << endl;
         j++;
+        printRegions(node->right, j);
     }
 }
 
+void TCPSACKRexmitQueue::info() const
+{
+    tcpEV << str() << endl;
+
+    uint j = 1;
+    printRegions(root, j);
+}
+
 void TCPSACKRexmitQueue::discardUpTo(uint32 seqNum)
 {
     ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
 
-    if (!rexmitQueue.empty())
+    // discard/delete regions from rexmit queue, which have been acked
+    while (root)
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
-
-        while ((i != rexmitQueue.end()) && seqLE(i->endSeqNum, seqNum)) // discard/delete regions from rexmit queue, which have been acked
-            i = rexmitQueue.erase(i);
+        Node *first = root;
+        while (first->left)
+            first = first->left;
 
-        if (i != rexmitQueue.end())
+        if (seqLess(seqNum, first->region.endSeqNum))
         {
-            ASSERT(seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
-            i->beginSeqNum = seqNum;
+            ASSERT(seqLE(first->region.beginSeqNum, seqNum));
+            if (first->region.beginSeqNum != seqNum)
+            {
+                // still the first region, so the tree order is not affected
+                first->region.beginSeqNum = seqNum;
+                regionChanged(seqNum);
+            }
+            break;
         }
+
+        Node *removed;
+        root = removeFirstNode(root, removed);
+        delete removed;
+        numRegions--;
     }
 
     begin = seqNum;
 
-    // TESTING queue:
-    ASSERT(checkQueue());
+    CHECK_QUEUE();
 }
 
 void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
@@ -96,59 +304,50 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
 
     ASSERT(seqLess(fromSeqNum, toSeqNum));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    if (!root || (end == fromSeqNum))
     {
         region.beginSeqNum = fromSeqNum;
         region.endSeqNum = toSeqNum;
         region.sacked = false;
         region.rexmitted = false;
-        rexmitQueue.push_back(region);
+        insertRegion(region);
         found = true;
         fromSeqNum = toSeqNum;
     }
     else
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
-
-        ASSERT(i != rexmitQueue.end());
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
-
-        if (i->beginSeqNum != fromSeqNum)
-        {
-            // chunk item
-            region = *i;
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
+        splitRegionAt(fromSeqNum);
 
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
+        Region *i;
+        while ((i = findRegion(fromSeqNum)) != NULL && seqLE(i->endSeqNum, toSeqNum))
         {
             i->rexmitted = true;
+            regionChanged(i->beginSeqNum);
             fromSeqNum = i->endSeqNum;
             found = true;
-            i++;
         }
 
         if (fromSeqNum != toSeqNum)
         {
-            bool beforeEnd = (i != rexmitQueue.end());
+            bool beforeEnd = (i != NULL);
 
-            ASSERT(i == rexmitQueue.end() || seqLess(i->beginSeqNum, toSeqNum));
+            ASSERT(i == NULL || seqLess(i->beginSeqNum, toSeqNum));
 
             region.beginSeqNum = fromSeqNum;
             region.endSeqNum = toSeqNum;
             region.sacked = beforeEnd ? i->sacked : false;
             region.rexmitted = beforeEnd;
-            rexmitQueue.insert(i, region);
-            found = true;
-            fromSeqNum = toSeqNum;
 
             if (beforeEnd)
+            {
+                // still follows the new region, so the tree order is not affected
                 i->beginSeqNum = toSeqNum;
+                regionChanged(toSeqNum);
+            }
+
+            insertRegion(region);
+            found = true;
+            fromSeqNum = toSeqNum;
         }
     }
 
@@ -162,26 +361,38 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
 
     ASSERT(found);
 
-    begin = rexmitQueue.front().beginSeqNum;
-    end = rexmitQueue.back().endSeqNum;
+    Node *node = root;
+    while (node->left)
+        node = node->left;
+    begin = node->region.beginSeqNum;
+    node = root;
+    while (node->right)
+        node = node->right;
+    end = node->region.endSeqNum;
 
-    // TESTING queue:
-    ASSERT(checkQueue());
+    CHECK_QUEUE();
 
     // tcpEV << "rexmitQ: rexmitQLength=" << getQueueLength() << "\n";
 }
 
+bool TCPSACKRexmitQueue::checkRegions(Node *node, uint32& b) const
+{
+    if (!node)
+        return true;
+
+    bool f = checkRegions(node->left, b);
+    f = f && (b == node->region.beginSeqNum);
+    f = f && seqLess(node->region.beginSeqNum, node->region.endSeqNum);
+    f = f && (!node->left || node->left->priority <= node->priority);
+    f = f && (!node->right || node->right->priority <= node->priority);
+    b = node->region.endSeqNum;
+    return checkRegions(node->right, b) && f;
+}
+
 bool TCPSACKRexmitQueue::checkQueue() const
 {
     uint32 b = begin;
-    bool f = true;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        f = f && (b == i->beginSeqNum);
-        f = f && seqLess(i->beginSeqNum, i->endSeqNum);
-        b = i->endSeqNum;
-    }
+    bool f = checkRegions(root, b);
 
     f = f && (b == end);
 
@@ -205,75 +416,67 @@ void TCPSACKRexmitQueue::setSackedBit(uint32 fromSeqNum, uint32 toSeqNum)
 
     bool found = false;
 
-    if (!rexmitQueue.empty())
+    if (root)
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
+        splitRegionAt(fromSeqNum);
 
-        ASSERT(i != rexmitQueue.end() && seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
-
-        if (i->beginSeqNum != fromSeqNum)
-        {
-            Region region = *i;
-
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
+        uint32 seqNum = fromSeqNum;
+        Region *i;
+        while ((i = findRegion(seqNum)) != NULL && seqLE(i->endSeqNum, toSeqNum))
         {
-            if (seqGE(i->beginSeqNum, fromSeqNum)) // Search region in queue!
+            found = true;
+            if (!i->sacked)
             {
-                found = true;
                 i->sacked = true; // set sacked bit
+                regionChanged(i->beginSeqNum);
             }
-
-            i++;
+            seqNum = i->endSeqNum;
         }
 
-        if (i != rexmitQueue.end() && seqLess(i->beginSeqNum, toSeqNum) && seqLess(toSeqNum, i->endSeqNum))
+        if (i != NULL && seqLess(i->beginSeqNum, toSeqNum) && seqLess(toSeqNum, i->endSeqNum))
         {
             Region region = *i;
 
             region.endSeqNum = toSeqNum;
             region.sacked = true;
-            rexmitQueue.insert(i, region);
             i->beginSeqNum = toSeqNum;
+            regionChanged(toSeqNum);
+            insertRegion(region);
         }
     }
 
     if (!found)
         tcpEV << "FAILED to set sacked bit for region: [" << fromSeqNum << ".." << toSeqNum << "). Not found in retransmission queue.\n";
 
-    ASSERT(checkQueue());
+    CHECK_QUEUE();
 }
 
 bool TCPSACKRexmitQueue::getSackedBit(uint32 seqNum) const
 {
     ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
     if (end == seqNum)
         return false;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, seqNum))
-        i++;
+    Region *i = findRegion(seqNum);
 
-    ASSERT((i != rexmitQueue.end()) && seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
+    ASSERT(i != NULL);
 
     return i->sacked;
 }
 
 uint32 TCPSACKRexmitQueue::getHighestSackedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    // descend to the last sacked region
+    Node *node = root;
+    while (node && node->summary.sackedBytes > 0)
     {
-        if (i->sacked)
-            return i->endSeqNum;
+        if (node->right && node->right->summary.sackedBytes > 0)
+            node = node->right;
+        else if (node->region.sacked)
+            return node->region.endSeqNum;
+        else
+            node = node->left;
     }
 
     return begin;
@@ -281,10 +484,16 @@ uint32 TCPSACKRexmitQueue::getHighestSackedSeqNum() const
 
 uint32 TCPSACKRexmitQueue::getHighestRexmittedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    // descend to the last rexmitted region
+    Node *node = root;
+    while (node && node->summary.numRexmitted > 0)
     {
-        if (i->rexmitted)
-            return i->endSeqNum;
+        if (node->right && node->right->summary.numRexmitted > 0)
+            node = node->right;
+        else if (node->region.rexmitted)
+            return node->region.endSeqNum;
+        else
+            node = node->left;
     }
 
     return begin;
@@ -294,22 +503,16 @@ uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 f
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    if (!root || (end == fromSeqNum))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
     uint32 bytes = 0;
+    Region *i;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-        i++;
-
-    while (i != rexmitQueue.end() && ((i->sacked || i->rexmitted)))
+    while ((i = findRegion(fromSeqNum)) != NULL && (i->sacked || i->rexmitted))
     {
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
-
         bytes += (i->endSeqNum - fromSeqNum);
         fromSeqNum = i->endSeqNum;
-        i++;
     }
 
     return bytes;
@@ -317,47 +520,29 @@ uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 f
 
 void TCPSACKRexmitQueue::resetSackedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->sacked = false; // reset sacked bit
+    resetBits(root, true, false); // reset sacked bit
 }
 
 void TCPSACKRexmitQueue::resetRexmittedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->rexmitted = false; // reset rexmitted bit
+    resetBits(root, false, true); // reset rexmitted bit
 }
 
 uint32 TCPSACKRexmitQueue::getTotalAmountOfSackedBytes() const
 {
-    uint32 bytes = 0;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
-
-    return bytes;
+    return root ? root->summary.sackedBytes : 0;
 }
 
 uint32 TCPSACKRexmitQueue::getAmountOfSackedBytes(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    uint32 bytes = 0;
-    RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin();
-
-    for (; i != rexmitQueue.rend() && seqLE(fromSeqNum, i->beginSeqNum); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
+    uint32 bytes = getSummaryFrom(root, fromSeqNum).sackedBytes;
 
-    if ( i != rexmitQueue.rend()
-            && seqLess(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum) && i->sacked)
-    {
-        bytes += (i->endSeqNum - fromSeqNum);
-    }
+    // only the part of the first region above fromSeqNum counts
+    Region *i = findRegion(fromSeqNum);
+    if (i && i->sacked)
+        bytes -= (fromSeqNum - i->beginSeqNum);
 
     return bytes;
 }
@@ -366,41 +551,20 @@ uint32 TCPSACKRexmitQueue::getNumOfDiscontiguousSacks(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (fromSeqNum == end))
+    if (!root || (fromSeqNum == end))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-    uint32 counter = 0;
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
-
     // search for discontiguous sacked regions
-    bool prevSacked = false;
-
-    while (i != rexmitQueue.end())
-    {
-        if (i->sacked && !prevSacked)
-            counter++;
-
-        prevSacked = i->sacked;
-        i++;
-    }
-
-    return counter;
+    return getSummaryFrom(root, fromSeqNum).sackedRuns;
 }
 
 void TCPSACKRexmitQueue::checkSackBlock(uint32 fromSeqNum, uint32 &length, bool &sacked, bool &rexmitted) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLess(fromSeqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
+    Region *i = findRegion(fromSeqNum); // search for seqNum
 
-    ASSERT(i != rexmitQueue.end());
-    ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+    ASSERT(i != NULL);
 
     length = (i->endSeqNum - fromSeqNum);
     sacked = i->sacked;
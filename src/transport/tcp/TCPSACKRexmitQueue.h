@@ -25,7 +25,13 @@
 
 
 /**
- * Retransmission data for SACK.
+ * Retransmission data for SACK (the "scoreboard" of RFC 3517).
+ *
+ * Regions are kept in a treap (randomized balanced binary search tree)
+ * ordered by sequence number. Every tree node caches the number of sacked
+ * bytes, sacked runs and rexmitted regions of its subtree, so locating a
+ * region and all the sum/count/highest queries used during SACK processing
+ * cost O(log n) in the number of regions.
  */
 class INET_API TCPSACKRexmitQueue
 {
@@ -40,12 +46,64 @@ class INET_API TCPSACKRexmitQueue
         bool rexmitted;   // indicates whether region has already been retransmitted by data sender
     };
 
-    typedef std::list<Region> RexmitQueue;
-    RexmitQueue rexmitQueue; // rexmitQueue is ordered by seqnum, and doesn't have overlapped Regions
+  protected:
+    // summary of a sequence of consecutive regions
+    struct Summary
+    {
+        bool empty;
+        uint32 sackedBytes;     // total length of sacked regions
+        uint32 sackedRuns;      // number of maximal runs of sacked regions
+        uint32 numRexmitted;    // number of rexmitted regions
+        bool firstSacked;       // first region is sacked
+        bool lastSacked;        // last region is sacked
+
+        Summary() : empty(true), sackedBytes(0), sackedRuns(0), numRexmitted(0), firstSacked(false), lastSacked(false) {}
+        Summary(const Region& region);
+        Summary operator+(const Summary& other) const;
+    };
+
+    struct Node
+    {
+        Region region;          // key: region.beginSeqNum
+        uint32 priority;        // heap order: parent priority >= child priority
+        Node *left;
+        Node *right;
+        Summary summary;        // summary of the subtree
+    };
 
+    Node *root;     // regions are ordered by seqnum, and don't overlap
+    uint32 numRegions;
+    uint32 randomState;  // for node priorities; the simulation RNGs are not touched
+
+  public:
     uint32 begin;  // 1st sequence number stored
     uint32 end;    // last sequence number stored + 1
 
+  protected:
+    static void updateSummary(Node *node);
+    static void deleteSubtree(Node *node);
+    static void split(Node *node, uint32 seqNum, Node *&left, Node *&right);
+    static Node *insertNode(Node *node, Node *newNode);
+    static Node *removeFirstNode(Node *node, Node *&removed);
+    static void refreshPath(Node *node, uint32 beginSeqNum);
+    static Summary getSummaryFrom(Node *node, uint32 seqNum);
+    static void resetBits(Node *node, bool sacked, bool rexmitted);
+
+    /** Returns the region containing seqNum, or NULL */
+    Region *findRegion(uint32 seqNum) const;
+
+    /** Inserts a new region (must not overlap stored regions) */
+    void insertRegion(const Region& region);
+
+    /** Splits the region containing seqNum at seqNum, if it does not begin there */
+    void splitRegionAt(uint32 seqNum);
+
+    /** Updates cached summaries after the flags or the end of the region beginning at beginSeqNum changed */
+    void regionChanged(uint32 beginSeqNum) { refreshPath(root, beginSeqNum); }
+
+    void printRegions(Node *node, uint& j) const;
+    bool checkRegions(Node *node, uint32& b) const;
+
   public:
     /**
      * Ctor
@@ -120,7 +178,7 @@ class INET_API TCPSACKRexmitQueue
     /**
      * Returns the number of blocks currently buffered in queue.
      */
-    virtual uint32 getQueueLength() const { return rexmitQueue.size(); }
+    virtual uint32 getQueueLength() const { return numRegions; }
 
     /**
      * Returns the highest sequence number sacked by data receiver.
@@ -0,0 +1,82 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "TCPByteStreamIntervalRcvQueue.h"
+
+
+Register_Class(TCPByteStreamIntervalRcvQueue);
+
+void TCPByteStreamIntervalRcvQueue::init(uint32 startSeq)
+{
+    rcv_nxt = startSeq;
+    regionMap.clear();
+}
+
+std::string TCPByteStreamIntervalRcvQueue::info() const
+{
+    std::stringstream os;
+    os << "rcv_nxt=" << rcv_nxt;
+    regionMap.print(os);
+    os << " " << regionMap.size() << "msgs";
+    return os.str();
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::insertBytesFromSegment(TCPSegment *tcpseg)
+{
+    rcv_nxt = regionMap.insert(createRegionFromSegment(tcpseg), rcv_nxt);
+    return rcv_nxt;
+}
+
+TCPVirtualDataRcvQueue::Region* TCPByteStreamIntervalRcvQueue::extractTo(uint32 seq)
+{
+    ASSERT(seqLE(seq, rcv_nxt));
+    return regionMap.extractTo(seq);
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::getAmountOfBufferedBytes()
+{
+    return regionMap.getNumBytes();
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::getQueueLength()
+{
+    return regionMap.size();
+}
+
+void TCPByteStreamIntervalRcvQueue::getQueueStatus()
+{
+    tcpEV << "receiveQLength=" << regionMap.size() << " " << info() << "\n";
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::getLE(uint32 fromSeqNum)
+{
+    return regionMap.getLE(fromSeqNum);
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::getRE(uint32 toSeqNum)
+{
+    return regionMap.getRE(toSeqNum);
+}
+
+uint32 TCPByteStreamIntervalRcvQueue::getFirstSeqNo()
+{
+    TCPVirtualDataRcvQueue::Region *first = regionMap.getFirst();
+    if (!first)
+        return rcv_nxt;
+    return seqMin(first->getBegin(), rcv_nxt);
+}
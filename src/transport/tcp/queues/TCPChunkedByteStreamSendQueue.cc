@@ -0,0 +1,140 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+
+#include "TCPChunkedByteStreamSendQueue.h"
+
+#include "ByteArrayMessage.h"
+#include "TCPSegment.h"
+
+#define CHUNK_SIZE  65536
+
+Register_Class(TCPChunkedByteStreamSendQueue);
+
+TCPChunkedByteStreamSendQueue::TCPChunkedByteStreamSendQueue() : TCPSendQueue()
+{
+    headOffset = 0;
+    begin = end = 0;
+}
+
+TCPChunkedByteStreamSendQueue::~TCPChunkedByteStreamSendQueue()
+{
+    releaseChunks();
+}
+
+void TCPChunkedByteStreamSendQueue::releaseChunks()
+{
+    for (std::deque<ByteChunk *>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+        (*it)->release();
+    chunks.clear();
+    headOffset = 0;
+}
+
+void TCPChunkedByteStreamSendQueue::init(uint32 startSeq)
+{
+    begin = startSeq;
+    end = startSeq;
+    releaseChunks();
+}
+
+std::string TCPChunkedByteStreamSendQueue::info() const
+{
+    std::stringstream out;
+    out << "[" << begin << ".." << end << "), " << (uint32)(end - begin) << " bytes in " << chunks.size() << " chunks";
+    return out.str();
+}
+
+void TCPChunkedByteStreamSendQueue::enqueueAppData(cPacket *msg)
+{
+    //tcpEV << "sendQ: " << info() << " enqueueAppData(bytes=" << msg->getByteLength() << ")\n";
+    ByteArrayMessage *bamsg = check_and_cast<ByteArrayMessage *>(msg);
+    const ByteArray& byteArray = bamsg->getByteArray();
+    int64 bytes = bamsg->getByteLength();
+    ASSERT(bytes == byteArray.getDataArraySize());
+
+    // fill up the last chunk, then continue in new ones
+    unsigned int copiedBytes = 0;
+    while (copiedBytes < bytes)
+    {
+        if (chunks.empty() || chunks.back()->getFreeSpace() == 0)
+            chunks.push_back(new ByteChunk(CHUNK_SIZE));
+        ByteChunk *chunk = chunks.back();
+        unsigned int cbytes = byteArray.copyDataToBuffer(chunk->getFreeSpacePtr(), chunk->getFreeSpace(), copiedBytes);
+        chunk->extend(cbytes);
+        copiedBytes += cbytes;
+    }
+    end += bytes;
+    delete msg;
+}
+
+uint32 TCPChunkedByteStreamSendQueue::getBufferStartSeq()
+{
+    return begin;
+}
+
+uint32 TCPChunkedByteStreamSendQueue::getBufferEndSeq()
+{
+    return end;
+}
+
+TCPSegment *TCPChunkedByteStreamSendQueue::createSegmentWithBytes(uint32 fromSeq, ulong numBytes)
+{
+    //tcpEV << "sendQ: " << info() << " createSeg(seq=" << fromSeq << " len=" << numBytes << ")\n";
+    ASSERT(seqLE(begin, fromSeq) && seqLE(fromSeq+numBytes, end));
+
+    TCPSegment *tcpseg = new TCPSegment();
+    tcpseg->setSequenceNo(fromSeq);
+    tcpseg->setPayloadLength(numBytes);
+
+    // the segment refers to the chunks holding [fromSeq, fromSeq+numBytes)
+    ByteSlice slice;
+    unsigned int offset = headOffset + (uint32)(fromSeq - begin);
+    unsigned int index = offset / CHUNK_SIZE;
+    offset %= CHUNK_SIZE;
+    for (ulong bytes = numBytes; bytes > 0; index++, offset = 0)
+    {
+        ByteChunk *chunk = chunks[index];
+        unsigned int cbytes = std::min((ulong)(chunk->getLength() - offset), bytes);
+        slice.append(chunk, offset, cbytes);
+        bytes -= cbytes;
+    }
+    tcpseg->setPayloadSlice(slice);
+
+    // give segment a name
+    char msgname[80];
+    sprintf(msgname, "tcpseg(l=%lu)", numBytes);
+    tcpseg->setName(msgname);
+
+    return tcpseg;
+}
+
+void TCPChunkedByteStreamSendQueue::discardUpTo(uint32 seqNum)
+{
+    //tcpEV << "sendQ: " << info() << " discardUpTo(seq=" << seqNum << ")\n";
+    ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
+    headOffset += seqNum - begin;
+    begin = seqNum;
+
+    // drop our reference to fully acknowledged chunks; segments in flight may still hold them
+    while (!chunks.empty() && headOffset >= chunks.front()->getCapacity())
+    {
+        headOffset -= chunks.front()->getCapacity();
+        chunks.front()->release();
+        chunks.pop_front();
+    }
+}
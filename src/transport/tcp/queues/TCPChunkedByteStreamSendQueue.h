@@ -0,0 +1,72 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TCPCHUNKEDBYTESTREAMSENDQUEUE_H
+#define __INET_TCPCHUNKEDBYTESTREAMSENDQUEUE_H
+
+#include <deque>
+
+#include "ByteSlice.h"
+#include "TCPSendQueue.h"
+
+/**
+ * Send queue for TCP_TRANSFER_BYTESTREAM mode. Application data is copied
+ * once into a ring of reference counted, fixed-size chunks. Segments carry
+ * a ByteSlice into these chunks instead of their own copy of the payload,
+ * so segmentation, retransmission and discardUpTo() never copy bytes.
+ * Chunks are freed when both the queue and all segments are done with them.
+ *
+ * @see TCPByteStreamSendQueue, TCPByteStreamRcvQueue
+ */
+class INET_API TCPChunkedByteStreamSendQueue : public TCPSendQueue
+{
+  protected:
+    std::deque<ByteChunk *> chunks;  // all chunks except the last one are full
+    unsigned int headOffset;   // offset of the byte at 'begin' in chunks.front()
+    uint32 begin;  // 1st sequence number stored
+    uint32 end;    // last sequence number stored +1
+
+  protected:
+    virtual void releaseChunks();
+
+  public:
+    /**
+     * Ctor
+     */
+    TCPChunkedByteStreamSendQueue();
+
+    /**
+     * Virtual dtor.
+     */
+    virtual ~TCPChunkedByteStreamSendQueue();
+
+    virtual void init(uint32 startSeq);
+
+    virtual std::string info() const;
+
+    virtual void enqueueAppData(cPacket *msg);
+
+    virtual uint32 getBufferStartSeq();
+
+    virtual uint32 getBufferEndSeq();
+
+    virtual TCPSegment *createSegmentWithBytes(uint32 fromSeq, ulong numBytes);
+
+    virtual void discardUpTo(uint32 seqNum);
+};
+
+#endif // __INET_TCPCHUNKEDBYTESTREAMSENDQUEUE_H
@@ -0,0 +1,130 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "TCPMsgBasedIntervalRcvQueue.h"
+
+#include "TCPSegment.h"
+
+Register_Class(TCPMsgBasedIntervalRcvQueue);
+
+
+TCPMsgBasedIntervalRcvQueue::~TCPMsgBasedIntervalRcvQueue()
+{
+    clearPayloadMap();
+}
+
+void TCPMsgBasedIntervalRcvQueue::clearPayloadMap()
+{
+    for (PayloadMap::iterator i = payloadMap.begin(); i != payloadMap.end(); ++i)
+    {
+        EV << "RcvQueue Destructor: Drop msg from " << this->getFullPath() <<
+                " Queue: offset=" << i->first <<
+                ", length=" << i->second->getByteLength() << endl;
+        delete i->second;
+    }
+    payloadMap.clear();
+}
+
+void TCPMsgBasedIntervalRcvQueue::init(uint32 startSeq)
+{
+    rcv_nxt = startSeq;
+    regionMap.clear();
+}
+
+std::string TCPMsgBasedIntervalRcvQueue::info() const
+{
+    std::stringstream os;
+    os << "rcv_nxt=" << rcv_nxt;
+    regionMap.print(os);
+    os << " " << payloadMap.size() << " msgs";
+    return os.str();
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::insertBytesFromSegment(TCPSegment *tcpseg)
+{
+    rcv_nxt = regionMap.insert(createRegionFromSegment(tcpseg), rcv_nxt);
+
+    cPacket *msg;
+    uint32 endSeqNo;
+    while (NULL != (msg = tcpseg->removeFirstPayloadMessage(endSeqNo)))
+    {
+        // insert, avoiding duplicates
+        if (!payloadMap.insert(std::make_pair(endSeqNo, msg)).second)
+            delete msg;
+    }
+
+    return rcv_nxt;
+}
+
+cPacket *TCPMsgBasedIntervalRcvQueue::extractBytesUpTo(uint32 seq)
+{
+    cPacket *msg = NULL;
+    if (!payloadMap.empty() && seqLess(payloadMap.begin()->first, seq))
+        seq = payloadMap.begin()->first;
+
+    Region *reg = extractTo(seq);
+    if (reg)
+    {
+        if (!payloadMap.empty() && payloadMap.begin()->first == reg->getEnd())
+        {
+            msg = payloadMap.begin()->second;
+            payloadMap.erase(payloadMap.begin());
+        }
+        delete reg;
+    }
+    return msg;
+}
+
+TCPVirtualDataRcvQueue::Region* TCPMsgBasedIntervalRcvQueue::extractTo(uint32 seq)
+{
+    ASSERT(seqLE(seq, rcv_nxt));
+    return regionMap.extractTo(seq);
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::getAmountOfBufferedBytes()
+{
+    return regionMap.getNumBytes();
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::getQueueLength()
+{
+    return regionMap.size();
+}
+
+void TCPMsgBasedIntervalRcvQueue::getQueueStatus()
+{
+    tcpEV << "receiveQLength=" << regionMap.size() << " " << info() << "\n";
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::getLE(uint32 fromSeqNum)
+{
+    return regionMap.getLE(fromSeqNum);
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::getRE(uint32 toSeqNum)
+{
+    return regionMap.getRE(toSeqNum);
+}
+
+uint32 TCPMsgBasedIntervalRcvQueue::getFirstSeqNo()
+{
+    Region *first = regionMap.getFirst();
+    if (!first)
+        return rcv_nxt;
+    return seqMin(first->getBegin(), rcv_nxt);
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_TCPMSGBASEDINTERVALRCVQUEUE_H
+#define __INET_TCPMSGBASEDINTERVALRCVQUEUE_H
+
+#include <map>
+
+#include "INETDefs.h"
+
+#include "TCPMsgBasedRcvQueue.h"
+#include "TCPRcvRegionMap.h"
+
+/**
+ * TCPMsgBasedRcvQueue that stores regions in a balanced interval map
+ * (see TCPRcvRegionMap) and payload messages in a map keyed by their end
+ * sequence number, for large windows with many out-of-order regions.
+ */
+class INET_API TCPMsgBasedIntervalRcvQueue : public TCPMsgBasedRcvQueue
+{
+  protected:
+    TCPRcvRegionMap regionMap;  // used instead of regionList
+    typedef std::map<uint32, cPacket *, TCPRcvRegionMap::SeqLess> PayloadMap;
+    PayloadMap payloadMap;      // used instead of payloadList
+
+    virtual TCPVirtualDataRcvQueue::Region* extractTo(uint32 toSeq);
+    virtual void clearPayloadMap();
+
+  public:
+    TCPMsgBasedIntervalRcvQueue() : TCPMsgBasedRcvQueue() {}
+    virtual ~TCPMsgBasedIntervalRcvQueue();
+
+    virtual void init(uint32 startSeq);
+    virtual std::string info() const;
+    virtual uint32 insertBytesFromSegment(TCPSegment *tcpseg);
+    virtual cPacket *extractBytesUpTo(uint32 seq);
+    virtual uint32 getAmountOfBufferedBytes();
+    virtual uint32 getQueueLength();
+    virtual void getQueueStatus();
+    virtual uint32 getLE(uint32 fromSeqNum);
+    virtual uint32 getRE(uint32 toSeqNum);
+    virtual uint32 getFirstSeqNo();
+};
+
+#endif
@@ -0,0 +1,131 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "TCPRcvRegionMap.h"
+
+
+void TCPRcvRegionMap::clear()
+{
+    for (RegionMap::iterator i = regionMap.begin(); i != regionMap.end(); ++i)
+        delete i->second;
+    regionMap.clear();
+    numBytes = 0;
+}
+
+uint32 TCPRcvRegionMap::insert(Region *seg, uint32 rcv_nxt)
+{
+#ifndef NDEBUG
+    if (!regionMap.empty())
+    {
+        uint32 ob = regionMap.begin()->second->getBegin();
+        uint32 oe = regionMap.rbegin()->second->getEnd();
+        uint32 nb = seg->getBegin();
+        uint32 ne = seg->getEnd();
+        uint32 minb = seqMin(ob, nb);
+        uint32 maxe = seqMax(oe, ne);
+        if (seqGE(minb, oe) || seqGE(minb, ne) || seqGE(ob, maxe) || seqGE(nb, maxe))
+            throw cRuntimeError("The new segment is [%u, %u) out of the acceptable range at the queue [%u, %u)",
+                    nb, ne, ob, oe);
+    }
+#endif
+
+    // The regions overlapping or touching seg are consecutive in the map,
+    // starting at the last region beginning at or before seg.
+    RegionMap::iterator i = regionMap.upper_bound(seg->getBegin());
+    if (i != regionMap.begin())
+    {
+        RegionMap::iterator prev = i;
+        --prev;
+        if (seqGE(prev->second->getEnd(), seg->getBegin()))
+            i = prev;
+    }
+
+    while (i != regionMap.end() && seqLE(i->second->getBegin(), seg->getEnd()))
+    {
+        if (!seg->merge(i->second))
+            throw cRuntimeError("Model error: merge of region [%u,%u) with [%u,%u) unsuccessful", i->second->getBegin(), i->second->getEnd(), seg->getBegin(), seg->getEnd());
+        numBytes -= i->second->getLength();
+        delete i->second;
+        regionMap.erase(i++);
+    }
+
+    regionMap.insert(i, std::make_pair(seg->getBegin(), seg));
+    numBytes += seg->getLength();
+
+    Region *first = regionMap.begin()->second;
+    if (seqGE(rcv_nxt, first->getBegin()))
+        rcv_nxt = first->getEnd();
+    return rcv_nxt;
+}
+
+TCPRcvRegionMap::Region *TCPRcvRegionMap::extractTo(uint32 seq)
+{
+    if (regionMap.empty())
+        return NULL;
+
+    Region *reg = regionMap.begin()->second;
+
+    if (seqLE(seq, reg->getBegin()))
+        return NULL;
+
+    // split() changes the begin of reg, which is its key in the map
+    regionMap.erase(regionMap.begin());
+
+    if (seqGE(seq, reg->getEnd()))
+    {
+        numBytes -= reg->getLength();
+        return reg;
+    }
+
+    Region *head = reg->split(seq);
+    regionMap.insert(std::make_pair(reg->getBegin(), reg));
+    numBytes -= head->getLength();
+    return head;
+}
+
+uint32 TCPRcvRegionMap::getLE(uint32 fromSeqNum) const
+{
+    // the region containing fromSeqNum is the last one beginning at or before it
+    RegionMap::const_iterator i = regionMap.upper_bound(fromSeqNum);
+    if (i != regionMap.begin())
+    {
+        --i;
+        if (seqLess(fromSeqNum, i->second->getEnd()))
+            return i->second->getBegin();
+    }
+    return fromSeqNum;
+}
+
+uint32 TCPRcvRegionMap::getRE(uint32 toSeqNum) const
+{
+    // the region containing toSeqNum-1 is the last one beginning before toSeqNum
+    RegionMap::const_iterator i = regionMap.lower_bound(toSeqNum);
+    if (i != regionMap.begin())
+    {
+        --i;
+        if (seqLE(toSeqNum, i->second->getEnd()))
+            return i->second->getEnd();
+    }
+    return toSeqNum;
+}
+
+void TCPRcvRegionMap::print(std::ostream& os) const
+{
+    for (RegionMap::const_iterator i = regionMap.begin(); i != regionMap.end(); ++i)
+        os << " [" << i->second->getBegin() << ".." << i->second->getEnd() << ")";
+}
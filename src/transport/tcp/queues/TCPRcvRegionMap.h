@@ -0,0 +1,91 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_TCPRCVREGIONMAP_H
+#define __INET_TCPRCVREGIONMAP_H
+
+#include <map>
+#include <ostream>
+
+#include "INETDefs.h"
+
+#include "TCPVirtualDataRcvQueue.h"
+
+/**
+ * Stores the regions of a receive queue in a map keyed by region begin,
+ * so that merging a segment, extracting data and the getLE()/getRE() lookups
+ * used for SACK generation cost O(log n) in the number of out-of-order regions.
+ * TCPVirtualDataRcvQueue keeps the regions in a list and scans it instead.
+ *
+ * Used by TCPVirtualDataIntervalRcvQueue, TCPByteStreamIntervalRcvQueue and
+ * TCPMsgBasedIntervalRcvQueue.
+ */
+class INET_API TCPRcvRegionMap
+{
+  public:
+    typedef TCPVirtualDataRcvQueue::Region Region;
+
+    /** Orders sequence numbers with seqLess(); valid while all keys are within a 2^31 window, as in a TCP receive window */
+    struct SeqLess
+    {
+        bool operator()(uint32 a, uint32 b) const {return seqLess(a, b);}
+    };
+
+  protected:
+    typedef std::map<uint32, Region*, SeqLess> RegionMap;   // key: region begin
+    RegionMap regionMap;
+    uint32 numBytes;    // total length of the regions
+
+  private:
+    // not copyable
+    TCPRcvRegionMap(const TCPRcvRegionMap&);
+    TCPRcvRegionMap& operator=(const TCPRcvRegionMap&);
+
+  public:
+    TCPRcvRegionMap() : numBytes(0) {}
+    ~TCPRcvRegionMap() { clear(); }
+
+    /** Deletes all regions */
+    void clear();
+
+    /**
+     * Merges the region (created by 'new', and owned by the map afterwards)
+     * with the stored ones, and returns the updated rcv_nxt.
+     */
+    uint32 insert(Region *region, uint32 rcv_nxt);
+
+    /** Removes and returns [begin..seq) of the first region, or NULL; same as TCPVirtualDataRcvQueue::extractTo() */
+    Region *extractTo(uint32 seq);
+
+    /** Same as TCPVirtualDataRcvQueue::getLE() */
+    uint32 getLE(uint32 fromSeqNum) const;
+
+    /** Same as TCPVirtualDataRcvQueue::getRE() */
+    uint32 getRE(uint32 toSeqNum) const;
+
+    /** Returns the first region, or NULL */
+    Region *getFirst() const { return regionMap.empty() ? NULL : regionMap.begin()->second; }
+
+    uint32 getNumBytes() const { return numBytes; }
+    int size() const { return regionMap.size(); }
+
+    /** Prints the regions as " [begin..end)" items */
+    void print(std::ostream& os) const;
+};
+
+#endif
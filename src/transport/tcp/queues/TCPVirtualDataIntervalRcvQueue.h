@@ -0,0 +1,52 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_TCPVIRTUALDATAINTERVALRCVQUEUE_H
+#define __INET_TCPVIRTUALDATAINTERVALRCVQUEUE_H
+
+#include "INETDefs.h"
+
+#include "TCPRcvRegionMap.h"
+#include "TCPVirtualDataRcvQueue.h"
+
+/**
+ * TCPVirtualDataRcvQueue that stores regions in a balanced interval map
+ * (see TCPRcvRegionMap), for large windows with many out-of-order regions.
+ */
+class INET_API TCPVirtualDataIntervalRcvQueue : public TCPVirtualDataRcvQueue
+{
+  protected:
+    TCPRcvRegionMap regionMap;  // used instead of regionList
+
+    virtual TCPVirtualDataRcvQueue::Region* extractTo(uint32 toSeq);
+
+  public:
+    TCPVirtualDataIntervalRcvQueue() : TCPVirtualDataRcvQueue() {}
+
+    virtual void init(uint32 startSeq);
+    virtual std::string info() const;
+    virtual uint32 insertBytesFromSegment(TCPSegment *tcpseg);
+    virtual uint32 getAmountOfBufferedBytes();
+    virtual uint32 getQueueLength();
+    virtual void getQueueStatus();
+    virtual uint32 getLE(uint32 fromSeqNum);
+    virtual uint32 getRE(uint32 toSeqNum);
+    virtual uint32 getFirstSeqNo();
+};
+
+#endif
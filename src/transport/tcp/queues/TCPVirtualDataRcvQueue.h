@@ -35,6 +35,8 @@
  */
 class INET_API TCPVirtualDataRcvQueue : public TCPReceiveQueue
 {
+    friend class TCPRcvRegionMap;
+
   protected:
     uint32 rcv_nxt;
 
@@ -78,7 +80,7 @@ class INET_API TCPVirtualDataRcvQueue : public TCPReceiveQueue
     void merge(TCPVirtualDataRcvQueue::Region *region);
 
     // Returns number of bytes extracted
-    TCPVirtualDataRcvQueue::Region* extractTo(uint32 toSeq);
+    virtual TCPVirtualDataRcvQueue::Region* extractTo(uint32 toSeq);
 
     /**
      * Create a new Region from tcpseg.
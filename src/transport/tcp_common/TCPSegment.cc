@@ -109,6 +109,8 @@ TCPSegment& TCPSegment::operator=(const TCPSegment& other)
 
 void TCPSegment::copy(const TCPSegment& other)
 {
+    payloadSlice = other.payloadSlice;
+    sliceBytes = other.sliceBytes;
     for (PayloadList::const_iterator i = other.payloadList.begin(); i != other.payloadList.end(); ++i)
         addPayloadMessage(i->msg->dup(), i->endSequenceNo);
 }
@@ -120,6 +122,8 @@ TCPSegment::~TCPSegment()
 
 void TCPSegment::clean()
 {
+    payloadSlice.clear();
+    sliceBytes.setDataArraySize(0);
     while (!payloadList.empty())
     {
         cPacket *msg = payloadList.front().msg;
@@ -134,6 +138,9 @@ void TCPSegment::truncateData(unsigned int truncleft, unsigned int truncright)
 
     if (0 != byteArray_var.getDataArraySize())
         byteArray_var.truncateData(truncleft, truncright);
+    if (!payloadSlice.isEmpty())
+        payloadSlice.truncate(truncleft, truncright);
+    sliceBytes.setDataArraySize(0);
 
     while (!payloadList.empty() && (payloadList.front().endSequenceNo - sequenceNo_var) <= truncleft)
     {
@@ -158,6 +165,7 @@ void TCPSegment::truncateData(unsigned int truncleft, unsigned int truncright)
 
 void TCPSegment::parsimPack(cCommBuffer *b)
 {
+    getByteArray();  // materialize the payload slice
     TCPSegment_Base::parsimPack(b);
     doPacking(b, payloadList);
 }
@@ -168,6 +176,49 @@ void TCPSegment::parsimUnpack(cCommBuffer *b)
     doUnpacking(b, payloadList);
 }
 
+ByteArray& TCPSegment::getByteArray()
+{
+    if (!payloadSlice.isEmpty())
+    {
+        unsigned int length = payloadSlice.getLength();
+        char *buffer = new char[length];
+        payloadSlice.copyDataToBuffer(buffer, length);
+        byteArray_var.assignBuffer(buffer, length);
+        payloadSlice.clear();
+        sliceBytes.setDataArraySize(0);
+    }
+    return byteArray_var;
+}
+
+const ByteArray& TCPSegment::getByteArray() const
+{
+    if (payloadSlice.isEmpty())
+        return byteArray_var;
+
+    if (sliceBytes.getDataArraySize() == 0)
+    {
+        unsigned int length = payloadSlice.getLength();
+        char *buffer = new char[length];
+        payloadSlice.copyDataToBuffer(buffer, length);
+        sliceBytes.assignBuffer(buffer, length);
+    }
+    return sliceBytes;
+}
+
+void TCPSegment::setByteArray(const ByteArray& byteArray)
+{
+    payloadSlice.clear();
+    sliceBytes.setDataArraySize(0);
+    byteArray_var = byteArray;
+}
+
+void TCPSegment::setPayloadSlice(const ByteSlice& slice)
+{
+    byteArray_var.setDataArraySize(0);
+    sliceBytes.setDataArraySize(0);
+    payloadSlice = slice;
+}
+
 void TCPSegment::setPayloadArraySize(unsigned int size)
 {
     throw cRuntimeError(this, "setPayloadArraySize() not supported, use addPayloadMessage()");
@@ -21,6 +21,7 @@
 
 #include <list>
 #include "INETDefs.h"
+#include "ByteSlice.h"
 #include "TCPSegment_m.h"
 
 
@@ -60,6 +61,8 @@ class INET_API TCPSegment : public TCPSegment_Base
   protected:
     typedef std::list<TCPPayloadMessage> PayloadList;
     PayloadList payloadList;
+    ByteSlice payloadSlice;  // payload bytes shared with the send queue, see getByteArray()
+    mutable ByteArray sliceBytes;  // copy of payloadSlice made by the const getByteArray(), empty if not made yet
 
   private:
     void copy(const TCPSegment& other);
@@ -74,6 +77,30 @@ class INET_API TCPSegment : public TCPSegment_Base
     virtual void parsimPack(cCommBuffer *b);
     virtual void parsimUnpack(cCommBuffer *b);
 
+    /**
+     * Returns the payload bytes. If the payload was set with setPayloadSlice(),
+     * it is copied into the byte array on the first call, and the slice is released.
+     */
+    virtual ByteArray& getByteArray();
+
+    /**
+     * Returns the payload bytes. If the payload was set with setPayloadSlice(),
+     * a copy of it is made on the first call, and kept along with the slice.
+     */
+    virtual const ByteArray& getByteArray() const;
+    virtual void setByteArray(const ByteArray& byteArray);
+
+    /**
+     * Returns the payload bytes shared with the send queue, or an empty slice
+     * if the payload is stored in the byte array.
+     */
+    virtual const ByteSlice& getPayloadSlice() const {return payloadSlice;}
+
+    /**
+     * Sets the payload bytes without copying them; replaces the byte array.
+     */
+    virtual void setPayloadSlice(const ByteSlice& slice);
+
     /** Generated but unused method, should not be called. */
     virtual void setPayloadArraySize(unsigned int size);
 
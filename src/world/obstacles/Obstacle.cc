@@ -17,9 +17,13 @@
 // Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //
 
-#include <set>
+#include <algorithm>
 #include "world/obstacles/Obstacle.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 typedef std::pair<Coord, double> CoordFrac;
 
@@ -40,6 +44,23 @@ void Obstacle::setShape(Coords shape) {
         bboxP2.x = std::max(i->x, bboxP2.x);
         bboxP2.y = std::max(i->y, bboxP2.y);
     }
+
+    size_t n = coords.size();
+    wallX.resize(n);
+    wallY.resize(n);
+    wallDX.resize(n);
+    wallDY.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        const Coord& c1 = coords[k];
+        const Coord& c2 = coords[k == 0 ? n - 1 : k - 1];
+        wallX[k] = c1.x;
+        wallY[k] = c1.y;
+        wallDX[k] = c2.x - c1.x;
+        wallDY[k] = c2.y - c1.y;
+    }
+    // one intersection per wall, plus the sender and receiver positions
+    intersectAt.clear();
+    intersectAt.reserve(n + 2);
 }
 
 const Obstacle::Coords& Obstacle::getShape() const {
@@ -74,20 +95,64 @@ namespace {
         return isInside;
     }
 
-    double segmentsIntersectAt(Coord p1From, Coord p1To, Coord p2From, Coord p2To) {
+    /**
+     * Intersects the segment p1From..p1To with n walls given as start points
+     * (x, y) and direction vectors (dx, dy). Stores the position (in [0, 1]) along
+     * the segment of each intersection in result, in wall order, and returns
+     * their number. The vectorized and the scalar loop perform the same floating
+     * point operations in the same order, so their results are bitwise identical.
+     */
+    size_t segmentIntersectsWalls(const Coord& p1From, const Coord& p1To, const double *x, const double *y, const double *dx, const double *dy, size_t n, double *result) {
         Coord p1Vec = p1To - p1From;
-        Coord p2Vec = p2To - p2From;
-        Coord p1p2 = p1From - p2From;
+        size_t count = 0;
+        size_t k = 0;
+
+#ifdef __SSE2__
+        // two walls at a time
+        const __m128d p1VecX = _mm_set1_pd(p1Vec.x);
+        const __m128d p1VecY = _mm_set1_pd(p1Vec.y);
+        const __m128d p1FromX = _mm_set1_pd(p1From.x);
+        const __m128d p1FromY = _mm_set1_pd(p1From.y);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        for (; k + 2 <= n; k += 2) {
+            __m128d p2VecX = _mm_loadu_pd(dx + k);
+            __m128d p2VecY = _mm_loadu_pd(dy + k);
+            __m128d p1p2X = _mm_sub_pd(p1FromX, _mm_loadu_pd(x + k));
+            __m128d p1p2Y = _mm_sub_pd(p1FromY, _mm_loadu_pd(y + k));
+
+            __m128d D = _mm_sub_pd(_mm_mul_pd(p1VecX, p2VecY), _mm_mul_pd(p1VecY, p2VecX));
+            __m128d p1Frac = _mm_div_pd(_mm_sub_pd(_mm_mul_pd(p2VecX, p1p2Y), _mm_mul_pd(p2VecY, p1p2X)), D);
+            __m128d p2Frac = _mm_div_pd(_mm_sub_pd(_mm_mul_pd(p1VecX, p1p2Y), _mm_mul_pd(p1VecY, p1p2X)), D);
+
+            // like the scalar code, a NaN fraction does not count as outside
+            __m128d outside = _mm_or_pd(_mm_or_pd(_mm_cmplt_pd(p1Frac, zero), _mm_cmpgt_pd(p1Frac, one)),
+                                        _mm_or_pd(_mm_cmplt_pd(p2Frac, zero), _mm_cmpgt_pd(p2Frac, one)));
+            int inside = ~_mm_movemask_pd(outside) & 3;
+            if (inside) {
+                double fracs[2];
+                _mm_storeu_pd(fracs, p1Frac);
+                if (inside & 1) result[count++] = fracs[0];
+                if (inside & 2) result[count++] = fracs[1];
+            }
+        }
+#endif
 
-        double D = (p1Vec.x * p2Vec.y - p1Vec.y * p2Vec.x);
+        for (; k < n; ++k) {
+            double p1p2X = p1From.x - x[k];
+            double p1p2Y = p1From.y - y[k];
 
-        double p1Frac = (p2Vec.x * p1p2.y - p2Vec.y * p1p2.x) / D;
-        if (p1Frac < 0 || p1Frac > 1) return -1;
+            double D = (p1Vec.x * dy[k] - p1Vec.y * dx[k]);
 
-        double p2Frac = (p1Vec.x * p1p2.y - p1Vec.y * p1p2.x) / D;
-        if (p2Frac < 0 || p2Frac > 1) return -1;
+            double p1Frac = (dx[k] * p1p2Y - dy[k] * p1p2X) / D;
+            if (p1Frac < 0 || p1Frac > 1) continue;
 
-        return p1Frac;
+            double p2Frac = (p1Vec.x * p1p2Y - p1Vec.y * p1p2X) / D;
+            if (p2Frac < 0 || p2Frac > 1) continue;
+
+            result[count++] = p1Frac;
+        }
+        return count;
     }
 
     double segmentsIntersectAt(Coord p1From, Coord p1To, Coord p2From, Coord p2To, Coord &IntersectPoint) {
@@ -156,22 +221,10 @@ double Obstacle::calculateReceivedPower(double pSend, double carrierFrequency, c
     if (getShape().size() < 2) return pSend;
 
     // get a list of points (in [0, 1]) along the line between sender and receiver where the beam intersects with this obstacle
-    std::multiset<double> intersectAt;
-    bool doesIntersect = false;
-    const Obstacle::Coords& shape = getShape();
-    Obstacle::Coords::const_iterator i = shape.begin();
-    Obstacle::Coords::const_iterator j = (shape.rbegin()+1).base();
-    for (; i != shape.end(); j = i++) {
-        Coord c1 = *i;
-        Coord c2 = *j;
-
-        double i = segmentsIntersectAt(senderPos, receiverPos, c1, c2);
-        if (i != -1) {
-            doesIntersect = true;
-            intersectAt.insert(i);
-        }
-
-    }
+    size_t numWallsTotal = wallX.size();
+    intersectAt.resize(numWallsTotal + 2);
+    intersectAt.resize(segmentIntersectsWalls(senderPos, receiverPos, &wallX[0], &wallY[0], &wallDX[0], &wallDY[0], numWallsTotal, &intersectAt[0]));
+    bool doesIntersect = !intersectAt.empty();
 
     // if beam interacts with neither walls nor matter: bail.
     bool senderInside = isPointInObstacle(senderPos, *this);
@@ -179,8 +232,8 @@ double Obstacle::calculateReceivedPower(double pSend, double carrierFrequency, c
     if (!doesIntersect && !senderInside && !receiverInside) return pSend;
 
     // make sure every other pair of points marks transition through matter and void, respectively.
-    if (senderInside) intersectAt.insert(0);
-    if (receiverInside) intersectAt.insert(1);
+    if (senderInside) intersectAt.push_back(0);
+    if (receiverInside) intersectAt.push_back(1);
     if ((intersectAt.size() % 2) != 0)
     {
         // problems in a corner
@@ -218,16 +271,17 @@ double Obstacle::calculateReceivedPower(double pSend, double carrierFrequency, c
         intersectAt.clear();
         for (unsigned int index = 0 ; index < intersectVector.size(); index++)
         {
-            intersectAt.insert(intersectVector[index].second);
+            intersectAt.push_back(intersectVector[index].second);
         }
-        if (senderInside) intersectAt.insert(0);
-        if (receiverInside) intersectAt.insert(1);
+        if (senderInside) intersectAt.push_back(0);
+        if (receiverInside) intersectAt.push_back(1);
     }
     ASSERT((intersectAt.size() % 2) == 0);
+    std::sort(intersectAt.begin(), intersectAt.end());
 
     // sum up distances in matter.
     double fractionInObstacle = 0;
-    for (std::multiset<double>::const_iterator i = intersectAt.begin(); i != intersectAt.end(); ) {
+    for (std::vector<double>::const_iterator i = intersectAt.begin(); i != intersectAt.end(); ) {
         double p1 = *(i++);
         double p2 = *(i++);
         fractionInObstacle += (p2 - p1);
@@ -50,6 +50,11 @@ class Obstacle {
         Coords coords;
         Coord bboxP1;
         Coord bboxP2;
+
+        // walls as contiguous arrays for the intersection kernel: wall k
+        // goes from coords[k] by (wallDX[k], wallDY[k]) to coords[k-1]
+        std::vector<double> wallX, wallY, wallDX, wallDY;
+        mutable std::vector<double> intersectAt; /**< scratch buffer of calculateReceivedPower(), capacity is set by setShape() */
 };
 
 #endif
@@ -18,8 +18,8 @@
 //
 
 #include <sstream>
-#include <map>
-#include <set>
+#include <algorithm>
+#include <string.h>
 
 #include "world/obstacles/ObstacleControl.h"
 
@@ -36,7 +36,24 @@ void ObstacleControl::initialize(int stage)
     if (stage == 0)
     {
         obstacles.clear();
+        obstacleList.clear();
+        bboxMinX.clear();
+        bboxMinY.clear();
+        bboxMaxX.clear();
+        bboxMaxY.clear();
+        freeObstacleSlots.clear();
+        visitStamps.clear();
+        visitEpoch = 0;
+
+        cacheSize = par("cacheSize");
+        if (cacheSize < 0)
+            error("cacheSize must not be negative");
+        int numBuckets = 1;
+        while (numBuckets < cacheSize) numBuckets *= 2;
         cacheEntries.clear();
+        cacheEntries.reserve(cacheSize);
+        cacheBuckets.assign(numBuckets, -1);
+        cacheHead = cacheTail = -1;
 
         obstaclesXml = par("obstacles");
     }
@@ -51,12 +68,17 @@ void ObstacleControl::initialize(int stage)
 }
 
 void ObstacleControl::finish() {
-    for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
-        for (ObstacleGridRow::iterator j = i->begin(); j != i->end(); ++j) {
-            while (j->begin() != j->end()) erase(*j->begin());
-        }
+    for (int i = 0; i < (int)obstacleList.size(); ++i) {
+        if (obstacleList[i]) eraseAt(i);
     }
     obstacles.clear();
+    obstacleList.clear();
+    bboxMinX.clear();
+    bboxMinY.clear();
+    bboxMaxX.clear();
+    bboxMaxY.clear();
+    freeObstacleSlots.clear();
+    visitStamps.clear();
 }
 
 void ObstacleControl::handleMessage(cMessage *msg) {
@@ -115,42 +137,117 @@ void ObstacleControl::addFromXml(cXMLElement* xml) {
 void ObstacleControl::add(Obstacle obstacle) {
     Obstacle* o = new Obstacle(obstacle);
 
-    size_t fromRow = std::max(0, int(o->getBboxP1().x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(o->getBboxP2().x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(o->getBboxP1().y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(o->getBboxP2().y / GRIDCELL_SIZE));
+    int index;
+    if (!freeObstacleSlots.empty()) {
+        index = freeObstacleSlots.back();
+        freeObstacleSlots.pop_back();
+        obstacleList[index] = o;
+    }
+    else {
+        index = obstacleList.size();
+        obstacleList.push_back(o);
+        bboxMinX.push_back(0);
+        bboxMinY.push_back(0);
+        bboxMaxX.push_back(0);
+        bboxMaxY.push_back(0);
+        visitStamps.push_back(0);
+    }
+    bboxMinX[index] = o->getBboxP1().x;
+    bboxMinY[index] = o->getBboxP1().y;
+    bboxMaxX[index] = o->getBboxP2().x;
+    bboxMaxY[index] = o->getBboxP2().y;
+    visitStamps[index] = 0;
+
+    size_t fromRow = gridIndex(o->getBboxP1().x);
+    size_t toRow = gridIndex(o->getBboxP2().x);
+    size_t fromCol = gridIndex(o->getBboxP1().y);
+    size_t toCol = gridIndex(o->getBboxP2().y);
     for (size_t row = fromRow; row <= toRow; ++row) {
         for (size_t col = fromCol; col <= toCol; ++col) {
             if (obstacles.size() < col+1) obstacles.resize(col+1);
             if (obstacles[col].size() < row+1) obstacles[col].resize(row+1);
-            (obstacles[col])[row].push_back(o);
+            (obstacles[col])[row].push_back(index);
         }
     }
 
     // visualize using AnnotationManager
     if (annotations) o->visualRepresentation = annotations->drawPolygon(o->getShape(), "red", annotationGroup);
 
-    cacheEntries.clear();
+    clearCache();
 }
 
 void ObstacleControl::erase(const Obstacle* obstacle) {
-    for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
-        for (ObstacleGridRow::iterator j = i->begin(); j != i->end(); ++j) {
-            for (ObstacleGridCell::iterator k = j->begin(); k != j->end(); ) {
-                Obstacle* o = *k;
-                if (o == obstacle) {
-                    k = j->erase(k);
-                } else {
-                    ++k;
-                }
-            }
-        }
+    std::vector<Obstacle*>::iterator it = std::find(obstacleList.begin(), obstacleList.end(), obstacle);
+    if (it != obstacleList.end()) {
+        eraseAt(it - obstacleList.begin());
+        return;
     }
 
     if (annotations && obstacle->visualRepresentation) annotations->erase(obstacle->visualRepresentation);
     delete obstacle;
 
-    cacheEntries.clear();
+    clearCache();
+}
+
+void ObstacleControl::eraseAt(int index) {
+    Obstacle* o = obstacleList[index];
+
+    size_t fromRow = gridIndex(bboxMinX[index]);
+    size_t toRow = gridIndex(bboxMaxX[index]);
+    size_t fromCol = gridIndex(bboxMinY[index]);
+    size_t toCol = gridIndex(bboxMaxY[index]);
+    for (size_t col = fromCol; col <= toCol && col < obstacles.size(); ++col) {
+        for (size_t row = fromRow; row <= toRow && row < obstacles[col].size(); ++row) {
+            ObstacleGridCell& cell = (obstacles[col])[row];
+            cell.erase(std::remove(cell.begin(), cell.end(), index), cell.end());
+        }
+    }
+
+    if (annotations && o->visualRepresentation) annotations->erase(o->visualRepresentation);
+    delete o;
+    obstacleList[index] = NULL;
+    freeObstacleSlots.push_back(index);
+
+    clearCache();
+}
+
+void ObstacleControl::startVisit() const {
+    // a new epoch marks all obstacles as not yet tested; reset the stamps on wrap-around
+    if (++visitEpoch == 0) {
+        std::fill(visitStamps.begin(), visitStamps.end(), 0);
+        visitEpoch = 1;
+    }
+}
+
+double ObstacleControl::attenuateByCell(int col, int row, double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, const Coord& bboxP1, const Coord& bboxP2) const {
+    if (col >= (int)obstacles.size()) return pSend;
+    const ObstacleGridRow& gridRow = obstacles[col];
+    if (row >= (int)gridRow.size()) return pSend;
+    const ObstacleGridCell& cell = gridRow[row];
+    for (ObstacleGridCell::const_iterator k = cell.begin(); k != cell.end(); ++k) {
+        int i = *k;
+
+        if (visitStamps[i] == visitEpoch) continue;
+        visitStamps[i] = visitEpoch;
+
+        // bail if bounding boxes cannot overlap
+        if (bboxMaxX[i] < bboxP1.x) continue;
+        if (bboxMinX[i] > bboxP2.x) continue;
+        if (bboxMaxY[i] < bboxP1.y) continue;
+        if (bboxMinY[i] > bboxP2.y) continue;
+
+        const Obstacle* o = obstacleList[i];
+        double pSendOld = pSend;
+
+        pSend = o->calculateReceivedPower(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+
+        // draw a "hit!" bubble
+        if (annotations && (pSend < pSendOld)) annotations->drawBubble(o->getBboxP1(), "hit");
+
+        // bail if attenuation is already extremely high
+        if (pSend < 1e-30) break;
+    }
+    return pSend;
 }
 
 double ObstacleControl::calculateReceivedPower(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const {
@@ -158,54 +255,117 @@ double ObstacleControl::calculateReceivedPower(double pSend, double carrierFrequ
 
     // return cached result, if available
     CacheKey cacheKey(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
-    CacheEntries::const_iterator cacheEntryIter = cacheEntries.find(cacheKey);
-    if (cacheEntryIter != cacheEntries.end()) return cacheEntryIter->second;
+    double cachedPower;
+    if (lookupCache(cacheKey, cachedPower)) return cachedPower;
 
     // calculate bounding box of transmission
     Coord bboxP1 = Coord(std::min(senderPos.x, receiverPos.x), std::min(senderPos.y, receiverPos.y));
     Coord bboxP2 = Coord(std::max(senderPos.x, receiverPos.x), std::max(senderPos.y, receiverPos.y));
 
-    size_t fromRow = std::max(0, int(bboxP1.x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(bboxP2.x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(bboxP1.y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(bboxP2.y / GRIDCELL_SIZE));
-
-    std::set<Obstacle*> processedObstacles;
-    for (size_t col = fromCol; col <= toCol; ++col) {
-        if (col >= obstacles.size()) break;
-        for (size_t row = fromRow; row <= toRow; ++row) {
-            if (row >= obstacles[col].size()) break;
-            const ObstacleGridCell& cell = (obstacles[col])[row];
-            for (ObstacleGridCell::const_iterator k = cell.begin(); k != cell.end(); ++k) {
-
-                Obstacle* o = *k;
+    int fromRow = gridIndex(bboxP1.x);
+    int toRow = gridIndex(bboxP2.x);
+    int fromCol = gridIndex(bboxP1.y);
+    int toCol = gridIndex(bboxP2.y);
+
+    // only visit the cells the line of sight crosses: walk the columns of
+    // cells along x, and in each one compute the y extent of the segment
+    // (slightly widened against rounding errors at cell borders)
+    const double epsilon = 1e-6;
+    startVisit();
+    for (int row = fromRow; row <= toRow && pSend >= 1e-30; ++row) {
+        double y1 = bboxP1.y;
+        double y2 = bboxP2.y;
+        if (fromRow != toRow) {
+            double x1 = row == fromRow ? bboxP1.x : double(row) * GRIDCELL_SIZE;
+            double x2 = row == toRow ? bboxP2.x : double(row + 1) * GRIDCELL_SIZE;
+            double slope = (receiverPos.y - senderPos.y) / (receiverPos.x - senderPos.x);
+            double ya = senderPos.y + (x1 - senderPos.x) * slope;
+            double yb = senderPos.y + (x2 - senderPos.x) * slope;
+            y1 = std::max(bboxP1.y, std::min(ya, yb));
+            y2 = std::min(bboxP2.y, std::max(ya, yb));
+        }
+        int firstCol = std::max(fromCol, gridIndex(y1 - epsilon));
+        int lastCol = std::min(toCol, gridIndex(y2 + epsilon));
+        for (int col = firstCol; col <= lastCol && pSend >= 1e-30; ++col)
+            pSend = attenuateByCell(col, row, pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle, bboxP1, bboxP2);
+    }
 
-                if (processedObstacles.find(o) != processedObstacles.end()) continue;
-                processedObstacles.insert(o);
+    // cache result
+    storeCache(cacheKey, pSend);
 
-                // bail if bounding boxes cannot overlap
-                if (o->getBboxP2().x < bboxP1.x) continue;
-                if (o->getBboxP1().x > bboxP2.x) continue;
-                if (o->getBboxP2().y < bboxP1.y) continue;
-                if (o->getBboxP1().y > bboxP2.y) continue;
+    return pSend;
+}
 
-                double pSendOld = pSend;
+unsigned int ObstacleControl::CacheKey::hash() const {
+    double fields[] = { pSend, carrierFrequency, senderPos.x, senderPos.y, senderAngle, receiverPos.x, receiverPos.y, receiverAngle };
+    const char *bytes = (const char *)fields;
+    unsigned int h = 0;
+    for (size_t i = 0; i + sizeof(uint32) <= sizeof(fields); i += sizeof(uint32)) {
+        uint32 w;
+        memcpy(&w, bytes + i, sizeof(uint32));
+        h = (h ^ w) * 0x9e3779b1u;
+    }
+    return h ^ (h >> 16);
+}
 
-                pSend = o->calculateReceivedPower(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+void ObstacleControl::clearCache() {
+    if (cacheEntries.empty()) return;
+    cacheEntries.clear();
+    std::fill(cacheBuckets.begin(), cacheBuckets.end(), -1);
+    cacheHead = cacheTail = -1;
+}
 
-                // draw a "hit!" bubble
-                if (annotations && (pSend < pSendOld)) annotations->drawBubble(o->getBboxP1(), "hit");
+void ObstacleControl::unlinkCacheEntry(int index) const {
+    CacheEntry& entry = cacheEntries[index];
+    if (entry.prev != -1) cacheEntries[entry.prev].next = entry.next; else cacheHead = entry.next;
+    if (entry.next != -1) cacheEntries[entry.next].prev = entry.prev; else cacheTail = entry.prev;
+}
 
-                // bail if attenuation is already extremely high
-                if (pSend < 1e-30) break;
+void ObstacleControl::linkCacheEntryAtHead(int index) const {
+    CacheEntry& entry = cacheEntries[index];
+    entry.prev = -1;
+    entry.next = cacheHead;
+    if (cacheHead != -1) cacheEntries[cacheHead].prev = index; else cacheTail = index;
+    cacheHead = index;
+}
 
+bool ObstacleControl::lookupCache(const CacheKey& key, double& value) const {
+    if (cacheSize == 0) return false;
+    int bucket = key.hash() & (cacheBuckets.size() - 1);
+    for (int i = cacheBuckets[bucket]; i != -1; i = cacheEntries[i].nextInBucket) {
+        if (cacheEntries[i].key == key) {
+            if (i != cacheHead) {
+                unlinkCacheEntry(i);
+                linkCacheEntryAtHead(i);
             }
+            value = cacheEntries[i].value;
+            return true;
         }
     }
+    return false;
+}
 
-    // cache result
-    if (cacheEntries.size() >= 1000) cacheEntries.clear();
-    cacheEntries[cacheKey] = pSend;
-
-    return pSend;
+void ObstacleControl::storeCache(const CacheKey& key, double value) const {
+    if (cacheSize == 0) return;
+    int mask = cacheBuckets.size() - 1;
+    int index;
+    if ((int)cacheEntries.size() < cacheSize) {
+        index = cacheEntries.size();
+        cacheEntries.push_back(CacheEntry());
+    }
+    else {
+        // evict the least recently used entry
+        index = cacheTail;
+        unlinkCacheEntry(index);
+        int* link = &cacheBuckets[cacheEntries[index].key.hash() & mask];
+        while (*link != index) link = &cacheEntries[*link].nextInBucket;
+        *link = cacheEntries[index].nextInBucket;
+    }
+    CacheEntry& entry = cacheEntries[index];
+    entry.key = key;
+    entry.value = value;
+    int bucket = key.hash() & mask;
+    entry.nextInBucket = cacheBuckets[bucket];
+    cacheBuckets[bucket] = index;
+    linkCacheEntryAtHead(index);
 }
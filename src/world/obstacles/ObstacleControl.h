@@ -21,7 +21,7 @@
 #ifndef WORLD_OBSTACLE_OBSTACLECONTROL_H
 #define WORLD_OBSTACLE_OBSTACLECONTROL_H
 
-#include <list>
+#include <vector>
 
 #include "INETDefs.h"
 
@@ -58,13 +58,14 @@ class INET_API ObstacleControl : public cSimpleModule
 
     protected:
         struct CacheKey {
-            const double pSend;
-            const double carrierFrequency;
-            const Coord senderPos;
-            const double senderAngle;
-            const Coord receiverPos;
-            const double receiverAngle;
-
+            double pSend;
+            double carrierFrequency;
+            Coord senderPos;
+            double senderAngle;
+            Coord receiverPos;
+            double receiverAngle;
+
+            CacheKey() : pSend(0), carrierFrequency(0), senderAngle(0), receiverAngle(0) {}
             CacheKey(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) :
                 pSend(pSend),
                 carrierFrequency(carrierFrequency),
@@ -73,40 +74,66 @@ class INET_API ObstacleControl : public cSimpleModule
                 receiverPos(receiverPos),
                 receiverAngle(receiverAngle) {
             }
-            bool operator<(const CacheKey& o) const {
-                if (senderPos.x < o.senderPos.x) return true;
-                if (senderPos.x > o.senderPos.x) return false;
-                if (senderPos.y < o.senderPos.y) return true;
-                if (senderPos.y > o.senderPos.y) return false;
-                if (receiverPos.x < o.receiverPos.x) return true;
-                if (receiverPos.x > o.receiverPos.x) return false;
-                if (receiverPos.y < o.receiverPos.y) return true;
-                if (receiverPos.y > o.receiverPos.y) return false;
-                if (pSend < o.pSend) return true;
-                if (pSend > o.pSend) return false;
-                if (senderAngle < o.senderAngle) return true;
-                if (senderAngle > o.senderAngle) return false;
-                if (receiverAngle < o.receiverAngle) return true;
-                if (receiverAngle > o.receiverAngle) return false;
-                if (carrierFrequency < o.carrierFrequency) return true;
-                if (carrierFrequency > o.carrierFrequency) return false;
-                return false;
+            bool operator==(const CacheKey& o) const {
+                return senderPos.x == o.senderPos.x && senderPos.y == o.senderPos.y &&
+                       receiverPos.x == o.receiverPos.x && receiverPos.y == o.receiverPos.y &&
+                       pSend == o.pSend && senderAngle == o.senderAngle && receiverAngle == o.receiverAngle &&
+                       carrierFrequency == o.carrierFrequency;
             }
+            unsigned int hash() const;
+        };
+
+        /**
+         * Entry of the received power cache. Entries are chained into hash
+         * buckets and into a doubly linked list in least recently used order;
+         * links are indices into cacheEntries, -1 meaning none.
+         */
+        struct CacheEntry {
+            CacheKey key;
+            double value;
+            int prev, next;     // LRU list, most recently used first
+            int nextInBucket;
         };
 
         enum { GRIDCELL_SIZE = 1024 };
 
-        typedef std::list<Obstacle*> ObstacleGridCell;
+        // the grid stores obstacle indices; see the obstacle* vectors below
+        typedef std::vector<int> ObstacleGridCell;
         typedef std::vector<ObstacleGridCell> ObstacleGridRow;
         typedef std::vector<ObstacleGridRow> Obstacles;
-        typedef std::map<CacheKey, double> CacheEntries;
+        typedef std::vector<CacheEntry> CacheEntries;
 
         cXMLElement* obstaclesXml; /**< obstacles to add at startup */
 
         Obstacles obstacles;
         AnnotationManager* annotations;
         AnnotationManager::Group* annotationGroup;
+
+        // obstacles by index, bounding boxes stored separately so that the
+        // filtering loop of calculateReceivedPower() reads contiguous memory;
+        // erased obstacles leave a NULL slot that is reused by add()
+        std::vector<Obstacle*> obstacleList;
+        std::vector<double> bboxMinX, bboxMinY, bboxMaxX, bboxMaxY;
+        std::vector<int> freeObstacleSlots;
+        mutable std::vector<unsigned int> visitStamps; /**< epoch of the last calculateReceivedPower() call that tested the obstacle */
+        mutable unsigned int visitEpoch;
+
+        int cacheSize; /**< maximum number of cached results */
         mutable CacheEntries cacheEntries;
+        mutable std::vector<int> cacheBuckets; /**< head of each hash chain; size is a power of 2 */
+        mutable int cacheHead, cacheTail;
+
+    protected:
+        static int gridIndex(double coord) { return std::max(0, int(coord / GRIDCELL_SIZE)); }
+        void eraseAt(int index);
+        void startVisit() const;
+        double attenuateByCell(int col, int row, double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, const Coord& bboxP1, const Coord& bboxP2) const;
+
+        void clearCache();
+        bool lookupCache(const CacheKey& key, double& value) const;
+        void storeCache(const CacheKey& key, double value) const;
+        void unlinkCacheEntry(int index) const;
+        void linkCacheEntryAtHead(int index) const;
 };
 
 class ObstacleControlAccess
@@ -59,6 +59,7 @@ void ChannelAccess::initialize(int stage)
         nb = NotificationBoardAccess().get();
         hostModule = findHost();
         myRadioRef = NULL;
+        mobility = NULL;
 
         positionUpdateArrived = false;
         // register to get a notification when position changes
@@ -85,6 +86,8 @@ void ChannelAccess::initialize(int stage)
         }
 
         myRadioRef = cc->registerRadio(this);
+        if (mobility)
+            cc->setRadioMobility(myRadioRef, mobility);
         cc->setRadioPosition(myRadioRef, radioPos);
     }
 }
@@ -116,7 +119,13 @@ void ChannelAccess::receiveSignal(cComponent *source, simsignal_t signalID, cObj
 {
     if (signalID == mobilityStateChangedSignal)
     {
-        IMobility *mobility = check_and_cast<IMobility*>(obj);
+        IMobility *sourceMobility = check_and_cast<IMobility*>(obj);
+        if (sourceMobility != mobility)
+        {
+            mobility = sourceMobility;
+            if (myRadioRef)
+                cc->setRadioMobility(myRadioRef, mobility);
+        }
         radioPos = mobility->getCurrentPosition();
         positionUpdateArrived = true;
 
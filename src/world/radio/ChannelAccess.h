@@ -31,6 +31,7 @@
 
 // Forward declarations
 class AirFrame;
+class IMobility;
 
 /**
  * @brief Basic class for all physical layers, please don't touch!!
@@ -58,10 +59,11 @@ class INET_API ChannelAccess : public BasicModule, protected cListener
     IChannelControl::RadioRef myRadioRef;  // Identifies this radio in the ChannelControl module
     cModule *hostModule;    // the host that contains this radio model
     Coord radioPos;  // the physical position of the radio (derived from display string or from mobility models)
+    IMobility *mobility;  // the mobility module that reported radioPos, or NULL
     bool positionUpdateArrived;
 
   public:
-    ChannelAccess() : nb(NULL), cc(NULL), myRadioRef(NULL), hostModule(NULL) {}
+    ChannelAccess() : nb(NULL), cc(NULL), myRadioRef(NULL), hostModule(NULL), mobility(NULL) {}
     virtual ~ChannelAccess();
 
     /**
@@ -18,11 +18,16 @@
 #include "ChannelControl.h"
 #include "FWMath.h"
 #include <cassert>
+#include <algorithm>
 
 #include "AirFrame_m.h"
+#include "IReceptionModel.h"
+#include "IMobility.h"
 
 #define coreEV (ev.isDisabled()||!coreDebug) ? EV : EV << "ChannelControl: "
 
+#define MIN_DISTANCE 0.001 // minimum distance 1 millimeter, as in Radio
+
 Define_Module(ChannelControl);
 
 
@@ -33,10 +38,10 @@ std::ostream& operator<<(std::ostream& os, const ChannelControl::RadioEntry& rad
     return os;
 }
 
-std::ostream& operator<<(std::ostream& os, const ChannelControl::TransmissionList& tl)
+std::ostream& operator<<(std::ostream& os, const ChannelControl::ChannelTransmissions& ct)
 {
-    for (ChannelControl::TransmissionList::const_iterator it = tl.begin(); it != tl.end(); ++it)
-        os << endl << *it;
+    for (ChannelControl::TransmissionHeap::const_iterator it = ct.heap.begin(); it != ct.heap.end(); ++it)
+        os << endl << *it->frame << " (until t=" << it->endTime << ")";
     return os;
 }
 
@@ -47,7 +52,7 @@ ChannelControl::ChannelControl()
 ChannelControl::~ChannelControl()
 {
     for (unsigned int i = 0; i < transmissions.size(); i++)
-        for (TransmissionList::iterator it = transmissions[i].begin(); it != transmissions[i].end(); it++)
+        for (TransmissionList::iterator it = transmissions[i].frames.begin(); it != transmissions[i].frames.end(); it++)
             delete *it;
 }
 
@@ -65,15 +70,38 @@ void ChannelControl::initialize()
     numChannels = par("numChannels");
     transmissions.resize(numChannels);
 
-    lastOngoingTransmissionsUpdate = 0;
-
     maxInterferenceDistance = calcInterfDist();
+    lazyPositionMargin = par("lazyPositionMargin");
+    if (lazyPositionMargin < 0)
+        error("lazyPositionMargin must not be negative");
+    lastPositionSweep = 0;
+    maxLazySpeed = 0;
+    grid.setCellSize(maxInterferenceDistance + lazyPositionMargin);
+
+    receptionFilterFraction = par("receptionFilterFraction");
+    if (receptionFilterFraction < 0 || receptionFilterFraction >= 1)
+        error("receptionFilterFraction must be in the [0,1) range");
+    numDeliveries = 0;
+    numElidedDeliveries = 0;
 
     WATCH(maxInterferenceDistance);
-    WATCH_LIST(radios);
+    WATCH(numDeliveries);
+    WATCH(numElidedDeliveries);
+    // the neighbor sets shown by the watch are not maintained in lazy mode
+    if (lazyPositionMargin == 0)
+        WATCH_LIST(radios);
     WATCH_VECTOR(transmissions);
 }
 
+void ChannelControl::finish()
+{
+    if (receptionFilterFraction > 0)
+    {
+        recordScalar("frames delivered", numDeliveries);
+        recordScalar("deliveries elided by reception filter", numElidedDeliveries);
+    }
+}
+
 /**
  * Calculation of the interference distance based on the transmitter
  * power, wavelength, pathloss coefficient and a threshold for the
@@ -111,9 +139,7 @@ ChannelControl::RadioRef ChannelControl::registerRadio(cModule *radio, cGate *ra
 {
     Enter_Method_Silent();
 
-    RadioRef radioRef = lookupRadio(radio);
-
-    if (radioRef)
+    if (lookupRadio(radio))
         throw cRuntimeError("Radio %s already registered", radio->getFullPath().c_str());
 
     if (!radioInGate)
@@ -125,8 +151,16 @@ ChannelControl::RadioRef ChannelControl::registerRadio(cModule *radio, cGate *ra
     re.isNeighborListValid = false;
     re.channel = 0;  // for now
     re.isActive = true;
+    re.receptionModel = NULL;
+    re.noiseFloor = 0;
+    re.posTime = simTime();
+    re.mobility = NULL;
+    re.maxSpeed = -1;
+    re.cell = grid.getCell(re.pos);
     radios.push_back(re);
-    return &radios.back(); // last element
+    RadioRef radioRef = &radios.back(); // last element
+    grid.insert(radioRef->cell, radioRef);
+    return radioRef;
 }
 
 void ChannelControl::unregisterRadio(RadioRef r)
@@ -137,16 +171,18 @@ void ChannelControl::unregisterRadio(RadioRef r)
         if (it->radioModule == r->radioModule)
         {
             RadioRef radioToRemove = &*it;
-            // erase radio from all registered radios' neighbor list
-            for (RadioList::iterator i2 = radios.begin(); i2 != radios.end(); ++i2)
+            // erase radio from its neighbors' neighbor list (the relation is symmetric)
+            for (std::set<RadioRef,RadioEntry::Compare>::iterator i2 = radioToRemove->neighbors.begin(); i2 != radioToRemove->neighbors.end(); ++i2)
             {
-                RadioRef otherRadio = &*i2;
+                RadioRef otherRadio = *i2;
                 otherRadio->neighbors.erase(radioToRemove);
                 otherRadio->isNeighborListValid = false;
-                radioToRemove->isNeighborListValid = false;
             }
+            radioToRemove->neighbors.clear();
+            radioToRemove->isNeighborListValid = false;
 
             // erase radio from registered radios
+            grid.remove(radioToRemove->cell, radioToRemove);
             radios.erase(it);
             return;
         }
@@ -167,7 +203,9 @@ ChannelControl::RadioRef ChannelControl::lookupRadio(cModule *radio)
 const ChannelControl::RadioRefVector& ChannelControl::getNeighbors(RadioRef h)
 {
     Enter_Method_Silent();
-    if (!h->isNeighborListValid)
+    if (lazyPositionMargin > 0)
+        findNeighbors(h);
+    else if (!h->isNeighborListValid)
     {
         h->neighborList.clear();
         for (std::set<RadioRef,RadioEntry::Compare>::iterator it = h->neighbors.begin(); it != h->neighbors.end(); it++)
@@ -177,13 +215,95 @@ const ChannelControl::RadioRefVector& ChannelControl::getNeighbors(RadioRef h)
     return h->neighborList;
 }
 
+void ChannelControl::updateRadioPosition(RadioRef r)
+{
+    if (r->maxSpeed > 0 && r->posTime < simTime())
+    {
+        // the mobility module normally emits mobilityStateChanged here, and
+        // ChannelAccess calls setRadioPosition() with the new position
+        Coord pos = r->mobility->getCurrentPosition();
+        if (r->posTime < simTime())
+            setRadioPosition(r, pos);
+    }
+}
+
+void ChannelControl::updateRadioPositions()
+{
+    coreEV << "updating the positions of lazily tracked radios\n";
+    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+        updateRadioPosition(&*it);
+
+    lastPositionSweep = simTime();
+    maxLazySpeed = 0;
+    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+        maxLazySpeed = std::max(maxLazySpeed, it->maxSpeed);
+}
+
+void ChannelControl::findNeighbors(RadioRef h)
+{
+    // every lazily tracked radio has been updated since lastPositionSweep, so none of
+    // them is farther from its stored position than maxDrift; as long as that is
+    // within lazyPositionMargin, all neighbors are in the cells adjacent to h's cell
+    simtime_t now = simTime();
+    if (maxLazySpeed * (now - lastPositionSweep).dbl() > lazyPositionMargin)
+        updateRadioPositions();
+    updateRadioPosition(h);
+
+    const Coord& hpos = h->pos;
+    double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
+    h->neighborList.clear();
+    candidates.clear();
+    grid.collect(h->cell, 1, candidates);
+    for (RadioRefVector::iterator it = candidates.begin(); it != candidates.end(); ++it)
+    {
+        RadioEntry *hi = *it;
+        if (hi == h)
+            continue;
+
+        // only query the current position of radios that may have moved into range
+        if (hi->maxSpeed > 0 && hi->posTime < now)
+        {
+            double maxDist = maxInterferenceDistance + hi->maxSpeed * (now - hi->posTime).dbl();
+            if (hpos.sqrdist(hi->pos) >= maxDist * maxDist)
+                continue;
+            updateRadioPosition(hi);
+        }
+
+        if (hpos.sqrdist(hi->pos) < maxDistSquared)
+            h->neighborList.push_back(hi);
+    }
+
+    // same order as the neighbor sets, the grid order is arbitrary
+    std::sort(h->neighborList.begin(), h->neighborList.end(), RadioEntry::Compare());
+    h->isNeighborListValid = false;
+}
+
 void ChannelControl::updateConnections(RadioRef h)
 {
     Coord& hpos = h->pos;
     double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
-    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+
+    // out of range: disconnect
+    for (std::set<RadioRef,RadioEntry::Compare>::iterator it = h->neighbors.begin(); it != h->neighbors.end();)
     {
-        RadioEntry *hi = &(*it);
+        RadioEntry *hi = *it;
+        if (hpos.sqrdist(hi->pos) < maxDistSquared)
+            ++it;
+        else
+        {
+            h->neighbors.erase(it++);
+            hi->neighbors.erase(h);
+            h->isNeighborListValid = hi->isNeighborListValid = false;
+        }
+    }
+
+    // nodes within communication range: connect; these can only be
+    // in the cells adjacent to h's cell because cell size == maxInterferenceDistance
+    candidates.clear();
+    grid.collect(h->cell, 1, candidates);
+    for (RadioRefVector::iterator it = candidates.begin(); it != candidates.end(); ++it)
+    {
+        RadioEntry *hi = *it;
         if (hi == h)
             continue;
 
@@ -191,23 +311,10 @@ void ChannelControl::updateConnections(RadioRef h)
         // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
         bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
 
-        if (inRange)
-        {
-            // nodes within communication range: connect
-            if (h->neighbors.insert(hi).second == true)
-            {
-                hi->neighbors.insert(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
-        }
-        else
+        if (inRange && h->neighbors.insert(hi).second == true)
         {
-            // out of range: disconnect
-            if (h->neighbors.erase(hi))
-            {
-                hi->neighbors.erase(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            hi->neighbors.insert(h);
+            h->isNeighborListValid = hi->isNeighborListValid = false;
         }
     }
 }
@@ -222,7 +329,27 @@ void ChannelControl::setRadioPosition(RadioRef r, const Coord& pos)
 {
     Enter_Method_Silent();
     r->pos = pos;
-    updateConnections(r);
+    r->posTime = simTime();
+    GridCell cell = grid.getCell(pos);
+    grid.move(r->cell, cell, r);
+    r->cell = cell;
+
+    if (lazyPositionMargin > 0)
+    {
+        // neighbors are found on demand; just remember the speed bound
+        // (radios whose mobility cannot tell it are tracked as usual)
+        double maxSpeed = r->mobility ? r->mobility->getMaxSpeed() : -1;
+        r->maxSpeed = maxSpeed >= 0 ? maxSpeed : -1;
+        maxLazySpeed = std::max(maxLazySpeed, r->maxSpeed);
+    }
+    else
+        updateConnections(r);
+}
+
+void ChannelControl::setRadioMobility(RadioRef r, IMobility *mobility)
+{
+    Enter_Method_Silent();
+    r->mobility = mobility;
 }
 
 void ChannelControl::setRadioChannel(RadioRef r, int channel)
@@ -233,13 +360,44 @@ void ChannelControl::setRadioChannel(RadioRef r, int channel)
     r->channel = channel;
 }
 
+void ChannelControl::setRadioReceptionModel(RadioRef r, IReceptionModel *receptionModel, double noiseFloor)
+{
+    Enter_Method_Silent();
+
+    r->receptionModel = receptionModel;
+    r->noiseFloor = noiseFloor;
+}
+
 const ChannelControl::TransmissionList& ChannelControl::getOngoingTransmissions(int channel)
 {
     Enter_Method_Silent();
 
     checkChannel(channel);
     purgeOngoingTransmissions();
-    return transmissions[channel];
+    return transmissions[channel].frames;
+}
+
+const ChannelControl::TransmissionList& ChannelControl::getOngoingTransmissions(RadioRef r, int channel)
+{
+    Enter_Method_Silent();
+
+    checkChannel(channel);
+    purgeOngoingTransmissions();
+
+    // only the transmissions within interference distance; the frames list is already
+    // in the order they were started. This is linear in the number of transmissions on
+    // the channel, which is small (it is bounded by the radios in mutual interference
+    // range), so a spatial index of the senders would not pay off for a call that only
+    // occurs on channel switches.
+    if (lazyPositionMargin > 0)
+        updateRadioPosition(r);
+    double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
+    const TransmissionList& frames = transmissions[channel].frames;
+    reachingFrames.clear();
+    for (TransmissionList::const_iterator it = frames.begin(); it != frames.end(); ++it)
+        if (r->pos.sqrdist((*it)->getSenderPos()) < maxDistSquared)
+            reachingFrames.push_back(*it);
+    return reachingFrames;
 }
 
 void ChannelControl::addOngoingTransmission(RadioRef h, AirFrame *frame)
@@ -255,66 +413,124 @@ void ChannelControl::addOngoingTransmission(RadioRef h, AirFrame *frame)
         return;
     }
 
-    // purge old transmissions from time to time
-    if (simTime() - lastOngoingTransmissionsUpdate > TRANSMISSION_PURGE_INTERVAL)
-    {
-        purgeOngoingTransmissions();
-        lastOngoingTransmissionsUpdate = simTime();
-    }
+    purgeOngoingTransmissions();
 
-    // register ongoing transmission
+    // register ongoing transmission; after endTime it cannot reach
+    // any radio within interference distance any more
     take(frame);
     frame->setTimestamp(); // store time of transmission start
-    transmissions[frame->getChannelNumber()].push_back(frame);
+    ChannelTransmissions& ct = transmissions[frame->getChannelNumber()];
+    OngoingTransmission transmission;
+    transmission.endTime = simTime() + frame->getDuration() + maxInterferenceDistance / SPEED_OF_LIGHT;
+    transmission.frame = ct.frames.insert(ct.frames.end(), frame);
+    TransmissionHeap& heap = ct.heap;
+    heap.push_back(transmission);
+    std::push_heap(heap.begin(), heap.end(), OngoingTransmissionEndsLater());
 }
 
 void ChannelControl::purgeOngoingTransmissions()
 {
+    simtime_t now = simTime();
     for (int i = 0; i < numChannels; i++)
     {
-        for (TransmissionList::iterator it = transmissions[i].begin(); it != transmissions[i].end();)
+        ChannelTransmissions& ct = transmissions[i];
+        TransmissionHeap& heap = ct.heap;
+        while (!heap.empty() && heap.front().endTime <= now)
         {
-            TransmissionList::iterator curr = it;
-            AirFrame *frame = *it;
-            it++;
-
-            if (frame->getTimestamp() + frame->getDuration() + TRANSMISSION_PURGE_INTERVAL < simTime())
-            {
-                delete frame;
-                transmissions[i].erase(curr);
-            }
+            delete *heap.front().frame;
+            ct.frames.erase(heap.front().frame);
+            std::pop_heap(heap.begin(), heap.end(), OngoingTransmissionEndsLater());
+            heap.pop_back();
         }
     }
 }
 
+bool ChannelControl::calculateMaxReceivedPowers(RadioRef srcRadio, AirFrame *airFrame)
+{
+    const Coord& senderPos = airFrame->getSenderPos();
+    int n = receivers.size();
+    if (n == 0)
+        return false;
+    distances.resize(n);
+    receivedPowers.resize(n);
+    for (int i=0; i<n; i++)
+        distances[i] = std::max(receivers[i]->pos.distance(senderPos), MIN_DISTANCE);
+
+    // obstacles are not considered: they can only decrease the received power
+    return srcRadio->receptionModel->calculateMaxReceivedPowers(airFrame->getPSend(), airFrame->getCarrierFrequency(), &distances[0], &receivedPowers[0], n);
+}
+
 void ChannelControl::sendToChannel(RadioRef srcRadio, AirFrame *airFrame)
 {
     // NOTE: no Enter_Method()! We pretend this method is part of ChannelAccess
 
-    // loop through all radios in range
+    // collect the radios in range listening on the frame's channel
     const RadioRefVector& neighbors = getNeighbors(srcRadio);
     int n = neighbors.size();
     int channel = airFrame->getChannelNumber();
+    if (lazyPositionMargin > 0)
+        airFrame->setSenderPos(srcRadio->pos); // the radio may not have known its current position
+    receivers.clear();
     for (int i=0; i<n; i++)
     {
         RadioRef r = neighbors[i];
         if (!r->isActive)
-        {
             coreEV << "skipping disabled radio interface \n";
-            continue;
-        }
-        if (r->channel == channel)
+        else if (r->channel != channel)
+            coreEV << "skipping radio listening on a different channel\n";
+        else
+            receivers.push_back(r);
+    }
+
+    // the optional reception filter needs an upper bound of the received power
+    // at each radio, computed with the sender's reception model; it must not
+    // draw random numbers, as that would change the random number streams of
+    // the simulation, so models without such a bound (fading, shadowing) are
+    // not filtered
+    bool filter = receptionFilterFraction > 0 && srcRadio->receptionModel && airFrame->getCarrierFrequency() > 0
+            && calculateMaxReceivedPowers(srcRadio, airFrame);
+
+    // sending to a receiver is deferred until the next one is found, so that
+    // the last receiver can get the original frame when it is not kept as an
+    // ongoing transmission. (Receivers share the encapsulated frame anyway:
+    // cPacket::dup() only increments its reference count, and it is copied on write.)
+    n = receivers.size();
+    cSimpleModule *srcModule = check_and_cast<cSimpleModule*>(srcRadio->radioModule);
+    RadioRef lastReceiver = NULL;
+    for (int i=0; i<n; i++)
+    {
+        RadioRef r = receivers[i];
+        if (filter && receivedPowers[i] < receptionFilterFraction * r->noiseFloor)
         {
-            coreEV << "sending message to radio listening on the same channel\n";
-            // account for propagation delay, based on distance in meters
-            // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = srcRadio->pos.distance(r->pos) / SPEED_OF_LIGHT;
-            check_and_cast<cSimpleModule*>(srcRadio->radioModule)->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), r->radioInGate);
+            coreEV << "not sending message to radio, received power " << receivedPowers[i] << "mW is far below its noise floor\n";
+            numElidedDeliveries++;
+            continue;
         }
-        else
-            coreEV << "skipping radio listening on a different channel\n";
+        coreEV << "sending message to radio listening on the same channel\n";
+        if (lastReceiver)
+            sendToRadio(srcModule, srcRadio, lastReceiver, airFrame->dup());
+        lastReceiver = r;
+    }
+
+    // we only keep track of ongoing transmissions so that we can support
+    // NICs switching channels (see addOngoingTransmission())
+    if (numChannels == 1 && lastReceiver)
+    {
+        sendToRadio(srcModule, srcRadio, lastReceiver, airFrame);
+        return;
     }
+    if (lastReceiver)
+        sendToRadio(srcModule, srcRadio, lastReceiver, airFrame->dup());
 
     // register transmission
     addOngoingTransmission(srcRadio, airFrame);
 }
+
+void ChannelControl::sendToRadio(cSimpleModule *srcModule, RadioRef srcRadio, RadioRef r, AirFrame *airFrame)
+{
+    // account for propagation delay, based on distance in meters
+    // Over 300m, dt=1us=10 bit times @ 10Mbps
+    simtime_t delay = srcRadio->pos.distance(r->pos) / SPEED_OF_LIGHT;
+    numDeliveries++;
+    srcModule->sendDirect(airFrame, delay, airFrame->getDuration(), r->radioInGate);
+}
@@ -24,12 +24,11 @@
 #include "INETDefs.h"
 #include "Coord.h"
 #include "IChannelControl.h"
+#include "SpatialGrid.h"
 
 // Forward declarations
 class AirFrame;
 
-#define TRANSMISSION_PURGE_INTERVAL 1.0
-
 /**
  * Keeps track of radios/NICs, their positions and channels;
  * also caches neighbor info (which other Radios are within
@@ -40,6 +39,10 @@ struct IChannelControl::RadioEntry {
     cGate *radioInGate;  // gate on host module used to receive airframes
     int channel;
     Coord pos; // cached radio position
+    GridCell cell; // cell of pos in the neighbor grid
+    simtime_t posTime; // when pos was last set
+    IMobility *mobility; // reports pos; may be NULL
+    double maxSpeed; // speed bound until the next position update if the radio is tracked lazily, -1 otherwise
 
     struct Compare {
         bool operator() (const RadioRef &lhs, const RadioRef &rhs) const {
@@ -49,10 +52,12 @@ struct IChannelControl::RadioEntry {
     };
     // we cache neighbors set in an std::vector, because std::set iteration is slow;
     // std::vector is created and updated on demand
-    std::set<RadioRef, Compare> neighbors; // cached neighbor list
+    std::set<RadioRef, Compare> neighbors; // cached neighbor list; empty when lazyPositionMargin > 0
     std::vector<RadioRef> neighborList;
     bool isNeighborListValid;
     bool isActive;
+    IReceptionModel *receptionModel; // reception model of the radio, or NULL if not known
+    double noiseFloor; // thermal noise of the radio in mW, or 0 if not known
 };
 
 /**
@@ -69,18 +74,44 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
 
     RadioList radios;
 
+    /** spatial index of the radios, with cells of maxInterferenceDistance size;
+     * neighbors of a radio are always found in the adjacent cells
+     */
+    SpatialGrid<RadioRef> grid;
+
+    /** scratch vector for grid queries, kept to avoid reallocation */
+    RadioRefVector candidates;
+
+    /** a transmission that may still reach radios within interference distance until endTime */
+    struct OngoingTransmission {
+        simtime_t endTime;
+        TransmissionList::iterator frame; // position in the frames list of the channel
+    };
+    struct OngoingTransmissionEndsLater {
+        bool operator() (const OngoingTransmission& lhs, const OngoingTransmission& rhs) const { return lhs.endTime > rhs.endTime; }
+    };
+    typedef std::vector<OngoingTransmission> TransmissionHeap;
+
+    /** the ongoing transmissions of a channel: the frames in the order they were started,
+     * and a binary min-heap ordered by endTime, so expired transmissions are always at the top
+     */
+    struct ChannelTransmissions {
+        TransmissionList frames;
+        TransmissionHeap heap;
+    };
+
     /** keeps track of ongoing transmissions; this is needed when a radio
      * switches to another channel (then it needs to know whether the target channel
      * is empty or busy)
      */
-    typedef std::vector<TransmissionList> ChannelTransmissionLists;
-    ChannelTransmissionLists transmissions; // indexed by channel number (size=numChannels)
+    typedef std::vector<ChannelTransmissions> ChannelTransmissionsVector;
+    ChannelTransmissionsVector transmissions; // indexed by channel number (size=numChannels)
 
-    /** used to clear the transmission list from time to time */
-    simtime_t lastOngoingTransmissionsUpdate;
+    /** scratch list for getOngoingTransmissions(), kept to avoid reallocation */
+    TransmissionList reachingFrames;
 
     friend std::ostream& operator<<(std::ostream&, const RadioEntry&);
-    friend std::ostream& operator<<(std::ostream&, const TransmissionList&);
+    friend std::ostream& operator<<(std::ostream&, const ChannelTransmissions&);
 
     /** Set debugging for the basic module*/
     bool coreDebug;
@@ -91,7 +122,37 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** the number of controlled channels */
     int numChannels;
 
+    /** frames arriving with less power than this fraction of the receiver's
+     * noise floor are not delivered at all; 0 disables the filter. Frames sent
+     * with a reception model without a deterministic upper bound of the received
+     * power (see IReceptionModel::calculateMaxReceivedPowers()) are not filtered.
+     */
+    double receptionFilterFraction;
+
+    /** when nonzero, radios whose mobility knows its maximum speed are tracked lazily:
+     * their positions are only queried when needed, and the neighbor grid has
+     * cells of maxInterferenceDistance+lazyPositionMargin size so that neighbors
+     * are found while no radio can have drifted more than lazyPositionMargin
+     */
+    double lazyPositionMargin;
+
+    /** all lazily tracked radios have been updated since this time */
+    simtime_t lastPositionSweep;
+
+    /** the largest speed bound of the lazily tracked radios since lastPositionSweep */
+    double maxLazySpeed;
+
+    /** scratch vectors for sendToChannel(), kept to avoid reallocation */
+    RadioRefVector receivers;
+    std::vector<double> distances;
+    std::vector<double> receivedPowers;
+
+    /** statistics: frames delivered to radios, and deliveries elided by the filter */
+    long numDeliveries;
+    long numElidedDeliveries;
+
   protected:
+    /** Updates the neighbor sets of h and of the radios around it; only radios in the adjacent grid cells are checked */
     virtual void updateConnections(RadioRef h);
 
     /** Calculate interference distance*/
@@ -100,6 +161,9 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** Reads init parameters and calculates a maximal interference distance*/
     virtual void initialize();
 
+    /** Records the delivery statistics of the reception filter */
+    virtual void finish();
+
     /** Throws away expired transmissions. */
     virtual void purgeOngoingTransmissions();
 
@@ -109,9 +173,28 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** Get the list of modules in range of the given host */
     virtual const RadioRefVector& getNeighbors(RadioRef h);
 
+    /** Lazy tracking: queries the current position of the radio from its mobility if it may have moved */
+    virtual void updateRadioPosition(RadioRef r);
+
+    /** Lazy tracking: queries the current position of all radios that may have moved */
+    virtual void updateRadioPositions();
+
+    /** Lazy tracking: collects the radios in range of the given radio (at their current positions) into its neighborList */
+    virtual void findNeighbors(RadioRef h);
+
     /** Notifies the channel control with an ongoing transmission */
     virtual void addOngoingTransmission(RadioRef h, AirFrame *frame);
 
+    /**
+     * Fills receivedPowers with an upper bound of the power each radio in receivers
+     * would receive, computed with the sender's reception model without drawing
+     * random numbers. Returns false if the model has no such bound.
+     */
+    virtual bool calculateMaxReceivedPowers(RadioRef srcRadio, AirFrame *airFrame);
+
+    /** Sends the frame from srcModule to the given radio, with the propagation delay */
+    virtual void sendToRadio(cSimpleModule *srcModule, RadioRef srcRadio, RadioRef r, AirFrame *airFrame);
+
     /** Returns the "handle" of a previously registered radio. The pointer to the registering (radio) module must be provided */
     virtual RadioRef lookupRadio(cModule *radioModule);
 
@@ -137,15 +220,24 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** To be called when the host moved; updates proximity info */
     virtual void setRadioPosition(RadioRef r, const Coord& pos);
 
+    /** Tells the channel the mobility module that reports the positions of the radio */
+    virtual void setRadioMobility(RadioRef r, IMobility *mobility);
+
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel);
 
+    /** Tells the channel the reception model and thermal noise (in mW) of the radio */
+    virtual void setRadioReceptionModel(RadioRef r, IReceptionModel *receptionModel, double noiseFloor);
+
     /** Returns the number of radio channels (frequencies) simulated */
     virtual int getNumChannels() { return numChannels; }
 
     /** Provides a list of transmissions currently on the air */
     virtual const TransmissionList& getOngoingTransmissions(int channel);
 
+    /** Provides the transmissions currently on the air on the given channel that can still reach the given radio */
+    virtual const TransmissionList& getOngoingTransmissions(RadioRef r, int channel);
+
     /** Called from ChannelAccess, to transmit a frame to the radios in range, on the frame's channel */
     virtual void sendToChannel(RadioRef srcRadio, AirFrame *airFrame);
 
@@ -25,6 +25,8 @@
 
 // Forward declarations
 class AirFrame;
+class IReceptionModel;
+class IMobility;
 
 /**
  * Interface to implement for a module that controls radio frequency channel access.
@@ -59,15 +61,32 @@ class INET_API IChannelControl
     /** To be called when the host moved; updates proximity info */
     virtual void setRadioPosition(RadioRef r, const Coord& pos) = 0;
 
+    /** Tells the channel the mobility module that reports the positions of the radio; may be used to query positions on demand */
+    virtual void setRadioMobility(RadioRef r, IMobility *mobility) = 0;
+
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel) = 0;
 
+    /**
+     * Tells the channel the reception model and thermal noise (in mW) of the radio.
+     * Optional; used for filtering deliveries that are far below the receiver's
+     * noise floor. The model is not owned by the channel.
+     */
+    virtual void setRadioReceptionModel(RadioRef r, IReceptionModel *receptionModel, double noiseFloor) = 0;
+
     /** Returns the number of radio channels (frequencies) simulated */
     virtual int getNumChannels() = 0;
 
     /** Provides a list of transmissions currently on the air */
     virtual const TransmissionList& getOngoingTransmissions(int channel) = 0;
 
+    /**
+     * Provides the transmissions currently on the air on the given channel that can still
+     * reach the given radio, in the order they were started. The default implementation
+     * returns all transmissions on the channel.
+     */
+    virtual const TransmissionList& getOngoingTransmissions(RadioRef r, int channel) { return getOngoingTransmissions(channel); }
+
     /** Called from ChannelAccess, to transmit a frame to the radios in range, on the frame's channel */
     virtual void sendToChannel(RadioRef srcRadio, AirFrame *airFrame) = 0;
 
@@ -17,6 +17,8 @@
 // author: Zoltan Bojthe
 //
 
+#include <algorithm>
+
 #include "IdealChannelModel.h"
 
 #include "IdealRadio.h"
@@ -24,6 +26,15 @@
 
 Define_Module(IdealChannelModel);
 
+// keeps the grid neighborhood of a query within int range; frames with
+// a larger range simply examine every occupied cell
+#define MAX_GRID_RADIUS  (1 << 16)
+
+static bool isRegisteredBefore(const IdealChannelModel::RadioEntry *a, const IdealChannelModel::RadioEntry *b)
+{
+    return a->serial < b->serial;
+}
+
 
 std::ostream& operator<<(std::ostream& os, const IdealChannelModel::RadioEntry& radio)
 {
@@ -33,6 +44,8 @@ std::ostream& operator<<(std::ostream& os, const IdealChannelModel::RadioEntry&
 
 IdealChannelModel::IdealChannelModel()
 {
+    nextSerial = 0;
+    useSpatialIndex = true;
 }
 
 IdealChannelModel::~IdealChannelModel()
@@ -44,6 +57,7 @@ void IdealChannelModel::initialize()
     EV << "initializing IdealChannelModel" << endl;
 
     maxTransmissionRange = 0;
+    useSpatialIndex = par("useSpatialIndex");
 
     WATCH_LIST(radios);
 }
@@ -52,9 +66,7 @@ IdealChannelModel::RadioEntry *IdealChannelModel::registerRadio(cModule *radio,
 {
     Enter_Method_Silent();
 
-    RadioEntry *radioRef = lookupRadio(radio);
-
-    if (radioRef)
+    if (lookupRadio(radio))
         throw cRuntimeError("Radio %s already registered", radio->getFullPath().c_str());
 
     IdealRadio *idealRadio = check_and_cast<IdealRadio *>(radio);
@@ -65,6 +77,10 @@ IdealChannelModel::RadioEntry *IdealChannelModel::registerRadio(cModule *radio,
     if (maxTransmissionRange < idealRadio->getTransmissionRange())
         maxTransmissionRange = idealRadio->getTransmissionRange();
 
+    // grow the cells so that the radios in range are (typically) in the adjacent cells
+    if (radioGrid.getCellSize() < maxTransmissionRange)
+        rebuildRadioGrid(maxTransmissionRange);
+
     if (!radioInGate)
         radioInGate = radio->gate("radioIn");
 
@@ -72,8 +88,12 @@ IdealChannelModel::RadioEntry *IdealChannelModel::registerRadio(cModule *radio,
     re.radioModule = radio;
     re.radioInGate = radioInGate->getPathStartGate();
     re.isActive = true;
+    re.cell = radioGrid.getCell(re.pos);
+    re.serial = nextSerial++;
     radios.push_back(re);
-    return &radios.back(); // last element
+    RadioEntry *radioRef = &radios.back(); // last element
+    radioGrid.insert(radioRef->cell, radioRef);
+    return radioRef;
 }
 
 void IdealChannelModel::recalculateMaxTransmissionRange()
@@ -89,6 +109,17 @@ void IdealChannelModel::recalculateMaxTransmissionRange()
     maxTransmissionRange = newRange;
 }
 
+void IdealChannelModel::rebuildRadioGrid(double cellSize)
+{
+    radioGrid.clear();
+    radioGrid.setCellSize(cellSize);
+    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+    {
+        it->cell = radioGrid.getCell(it->pos);
+        radioGrid.insert(it->cell, &*it);
+    }
+}
+
 void IdealChannelModel::unregisterRadio(RadioEntry *r)
 {
     Enter_Method_Silent();
@@ -97,6 +128,7 @@ void IdealChannelModel::unregisterRadio(RadioEntry *r)
         if (it->radioModule == r->radioModule)
         {
             // erase radio from registered radios
+            radioGrid.remove(it->cell, &*it);
             radios.erase(it);
             maxTransmissionRange = -1.0;    // invalidate the value
             return;
@@ -117,6 +149,9 @@ IdealChannelModel::RadioEntry *IdealChannelModel::lookupRadio(cModule *radio)
 void IdealChannelModel::setRadioPosition(RadioEntry *r, const Coord& pos)
 {
     r->pos = pos;
+    GridCell cell = radioGrid.getCell(pos);
+    radioGrid.move(r->cell, cell, r);
+    r->cell = cell;
 }
 
 void IdealChannelModel::sendToChannel(RadioEntry *srcRadio, IdealAirFrame *airFrame)
@@ -126,27 +161,50 @@ void IdealChannelModel::sendToChannel(RadioEntry *srcRadio, IdealAirFrame *airFr
     if (maxTransmissionRange < 0.0)    // invalid value
         recalculateMaxTransmissionRange();
 
-    double sqrTransmissionRange = airFrame->getTransmissionRange()*airFrame->getTransmissionRange();
+    double transmissionRange = airFrame->getTransmissionRange();
+    double sqrTransmissionRange = transmissionRange * transmissionRange;
 
-    // loop through all radios
-    for (RadioList::iterator it=radios.begin(); it !=radios.end(); ++it)
+    if (!useSpatialIndex)
+    {
+        // loop through all radios
+        for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+            sendToRadio(srcRadio, &*it, airFrame, sqrTransmissionRange);
+    }
+    else
     {
-        RadioEntry *r = &*it;
-        if (r == srcRadio)
-            continue;   // skip sender radio
+        // only the radios in the cells around the sender can be in range;
+        // cells are at least maxTransmissionRange wide, so this is usually
+        // the 3x3x3 block around the sender's cell
+        double cellSize = radioGrid.getCellSize();
+        int radius = 0;
+        if (cellSize > 0)
+            radius = (int)std::min(ceil(transmissionRange / cellSize), (double)MAX_GRID_RADIUS);
+        candidates.clear();
+        radioGrid.collect(srcRadio->cell, radius, candidates);
+
+        // deliver in registration order, like the loop over all radios does
+        std::sort(candidates.begin(), candidates.end(), isRegisteredBefore);
+        for (RadioEntryVector::iterator it = candidates.begin(); it != candidates.end(); ++it)
+            sendToRadio(srcRadio, *it, airFrame, sqrTransmissionRange);
+    }
+    delete airFrame;
+}
 
-        if (!r->isActive)
-            continue;   // skip disabled radio interfaces
+void IdealChannelModel::sendToRadio(RadioEntry *srcRadio, RadioEntry *r, IdealAirFrame *airFrame, double sqrTransmissionRange)
+{
+    if (r == srcRadio)
+        return;   // skip sender radio
 
-        double sqrdist = srcRadio->pos.sqrdist(r->pos);
-        if (sqrdist <= sqrTransmissionRange)
-        {
-            // account for propagation delay, based on distance in meters
-            // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = sqrt(sqrdist) / SPEED_OF_LIGHT;
-            check_and_cast<cSimpleModule*>(srcRadio->radioModule)->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), r->radioInGate);
-        }
+    if (!r->isActive)
+        return;   // skip disabled radio interfaces
+
+    double sqrdist = srcRadio->pos.sqrdist(r->pos);
+    if (sqrdist <= sqrTransmissionRange)
+    {
+        // account for propagation delay, based on distance in meters
+        // Over 300m, dt=1us=10 bit times @ 10Mbps
+        simtime_t delay = sqrt(sqrdist) / SPEED_OF_LIGHT;
+        check_and_cast<cSimpleModule*>(srcRadio->radioModule)->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), r->radioInGate);
     }
-    delete airFrame;
 }
 
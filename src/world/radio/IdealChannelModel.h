@@ -24,6 +24,7 @@
 #include "INETDefs.h"
 
 #include "Coord.h"
+#include "SpatialGrid.h"
 
 // Forward declarations
 class IdealAirFrame;
@@ -35,6 +36,10 @@ class IdealRadio;
  *
  * Stores infos about all registered radios.
  * Forward messages to all other radios in max transmission range
+ *
+ * Radios are indexed by a uniform grid (cell size is the largest transmission
+ * range), so a transmission only examines the radios in the cells around the
+ * sender instead of all registered radios.
  */
 class INET_API IdealChannelModel : public cSimpleModule
 {
@@ -45,11 +50,24 @@ class INET_API IdealChannelModel : public cSimpleModule
         cGate *radioInGate;     // gate on host module used to receive airframes
         Coord pos;              // cached radio position
         bool isActive;          // radio module is active
+        GridCell cell;          // cell of pos in radioGrid
+        unsigned int serial;    // registration order, determines delivery order
     };
 
   protected:
     typedef std::list<RadioEntry> RadioList;
+    typedef std::vector<RadioEntry *> RadioEntryVector;
     RadioList radios;    // list of registered radios
+    unsigned int nextSerial;
+
+    /** if false, every transmission checks all registered radios (the index is still maintained) */
+    bool useSpatialIndex;
+
+    /** spatial index of the radios, with cells of (at least) maxTransmissionRange size */
+    SpatialGrid<RadioEntry *> radioGrid;
+
+    /** scratch vector for grid queries, kept to avoid reallocation */
+    RadioEntryVector candidates;
 
     friend std::ostream& operator<<(std::ostream&, const RadioEntry&);
 
@@ -66,6 +84,12 @@ class INET_API IdealChannelModel : public cSimpleModule
     /** recalculate the largest transmission range in the network.*/
     virtual void recalculateMaxTransmissionRange();
 
+    /** Re-inserts all radios into radioGrid, using the given cell size */
+    virtual void rebuildRadioGrid(double cellSize);
+
+    /** Sends a copy of airFrame to r if it is active and within sqrTransmissionRange */
+    virtual void sendToRadio(RadioEntry *srcRadio, RadioEntry *r, IdealAirFrame *airFrame, double sqrTransmissionRange);
+
   public:
     IdealChannelModel();
     virtual ~IdealChannelModel();
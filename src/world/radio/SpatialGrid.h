@@ -0,0 +1,171 @@
+//
+// Copyright (C) 2013 OpenSim Ltd
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_SPATIALGRID_H
+#define __INET_SPATIALGRID_H
+
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "INETDefs.h"
+
+#include "Coord.h"
+
+
+/**
+ * Index of a cell in a SpatialGrid.
+ */
+struct INET_API GridCell
+{
+    int x, y, z;
+
+    GridCell() : x(0), y(0), z(0) {}
+    GridCell(int x, int y, int z) : x(x), y(y), z(z) {}
+
+    bool operator==(const GridCell& other) const { return x == other.x && y == other.y && z == other.z; }
+    bool operator!=(const GridCell& other) const { return !(*this == other); }
+    bool operator<(const GridCell& other) const {
+        if (x != other.x) return x < other.x;
+        if (y != other.y) return y < other.y;
+        return z < other.z;
+    }
+};
+
+/**
+ * Uniform grid over the 3D space that buckets items (typically radio handles)
+ * by the cell their position falls into. Only non-empty cells are stored,
+ * so the memory footprint is proportional to the number of items and not
+ * to the size of the playground.
+ *
+ * With the cell size chosen to be the largest interaction distance, all
+ * items within that distance of a position are found in the 3x3x3 block of
+ * cells around it, i.e. a query costs O(local density) instead of O(N).
+ *
+ * The grid does not remember item positions; callers keep the GridCell
+ * returned by getCell() and pass it back on remove() and move().
+ */
+template <typename T>
+class SpatialGrid
+{
+  public:
+    typedef std::vector<T> Bucket;
+
+  protected:
+    typedef std::map<GridCell, Bucket> CellMap;
+
+    double cellSize;
+    CellMap cells;
+    int numItems;
+
+  protected:
+    static int toIndex(double coord, double cellSize) {
+        double d = floor(coord / cellSize);
+        // clamp to keep far-away (or bogus) coordinates from overflowing the index
+        if (d > INT_MAX / 2) return INT_MAX / 2;
+        if (d < INT_MIN / 2) return INT_MIN / 2;
+        return (int)d;
+    }
+
+  public:
+    SpatialGrid(double cellSize = 0) : cellSize(cellSize), numItems(0) {}
+
+    /** Sets the cell size. Only allowed while the grid is empty. */
+    void setCellSize(double size) {
+        ASSERT(numItems == 0);
+        cellSize = size;
+    }
+
+    double getCellSize() const { return cellSize; }
+
+    int size() const { return numItems; }
+
+    /** Returns the cell the given position belongs to. A non-positive cell size puts everything into one cell. */
+    GridCell getCell(const Coord& pos) const {
+        if (!(cellSize > 0))
+            return GridCell();
+        return GridCell(toIndex(pos.x, cellSize), toIndex(pos.y, cellSize), toIndex(pos.z, cellSize));
+    }
+
+    void insert(const GridCell& cell, const T& item) {
+        cells[cell].push_back(item);
+        numItems++;
+    }
+
+    void remove(const GridCell& cell, const T& item) {
+        typename CellMap::iterator it = cells.find(cell);
+        ASSERT(it != cells.end());
+        Bucket& bucket = it->second;
+        typename Bucket::iterator i = std::find(bucket.begin(), bucket.end(), item);
+        ASSERT(i != bucket.end());
+        *i = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty())
+            cells.erase(it);
+        numItems--;
+    }
+
+    /** Moves the item between cells; a no-op if the cell did not change. */
+    void move(const GridCell& from, const GridCell& to, const T& item) {
+        if (from != to) {
+            remove(from, item);
+            insert(to, item);
+        }
+    }
+
+    void clear() {
+        cells.clear();
+        numItems = 0;
+    }
+
+    /**
+     * Appends all items found in cells at most 'radius' cells away from
+     * 'center' (along every axis) to 'result'. The order of the items is
+     * unspecified.
+     */
+    void collect(const GridCell& center, int radius, std::vector<T>& result) const {
+        if (cells.empty())
+            return;
+        // iterate over the smaller one of the neighborhood and the set of occupied cells
+        long long side = 2LL * radius + 1;
+        if (side * side * side > (long long)cells.size()) {
+            for (typename CellMap::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+                const GridCell& c = it->first;
+                if (abs(c.x - center.x) <= radius && abs(c.y - center.y) <= radius && abs(c.z - center.z) <= radius)
+                    result.insert(result.end(), it->second.begin(), it->second.end());
+            }
+        }
+        else {
+            for (int dx = -radius; dx <= radius; dx++) {
+                // std::map is ordered by (x,y,z): one lower_bound per (x,y) row is enough
+                for (int dy = -radius; dy <= radius; dy++) {
+                    GridCell first(center.x + dx, center.y + dy, center.z - radius);
+                    for (typename CellMap::const_iterator it = cells.lower_bound(first); it != cells.end(); ++it) {
+                        const GridCell& c = it->first;
+                        if (c.x != first.x || c.y != first.y || c.z > center.z + radius)
+                            break;
+                        result.insert(result.end(), it->second.begin(), it->second.end());
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif  // __INET_SPATIALGRID_H
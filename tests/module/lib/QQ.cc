@@ -51,17 +51,20 @@ void QQ::handleMessage(cMessage *msg)
 
     cChannel *ch = outGate->findTransmissionChannel();
 
-    if (outGate->isConnected())
+    if (outGate->isConnected() && !timer->isScheduled() && !queue.empty())
     {
         if (ch && ch->isBusy())
         {
-            cancelEvent(timer);
             scheduleAt(ch->getTransmissionFinishTime(), timer);
         }
         else
         {
             msg = check_and_cast<cMessage *>(queue.pop());
             send(msg, outGate);
+
+            // continue with the rest of the queue when the transmission is over
+            if (ch && !queue.empty())
+                scheduleAt(ch->getTransmissionFinishTime(), timer);
         }
     }
 }